@@ -1,12 +1,119 @@
 #include "mpterm.h"
+#include "mpbatch.h"
 
 #include <charconv>
 #include <cstring>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <thread>
+#include <regex>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <memory_resource>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <io.h>
+#include <malloc.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+ * Počítadlo alokací na haldě pro benchmark. Náhrada globálního operator new
+ * (new[] i delete[] se na něj ve výchozí implementaci převádějí). Zarovnaná varianta
+ * je potřeba kvůli std::pmr::new_delete_resource, přes který alokuje mpn::LimbVector.
+ */
+std::atomic<size_t> heap_allocations{0};
+
+// delete mimo inline: GCC by jinak u volajícího viděl free na ukazateli z operator new
+// a hlásil -Wmismatched-new-delete, i když new i delete jsou náhrady nad malloc/free
+#if defined(__GNUC__)
+#define SEM_2_NOINLINE __attribute__((noinline))
+#else
+#define SEM_2_NOINLINE
+#endif
+
+void* operator new(std::size_t size) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+SEM_2_NOINLINE void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+SEM_2_NOINLINE void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// MSVC nemá std::aligned_alloc, zarovnaný blok se tam musí uvolnit přes _aligned_free
+void* operator new(std::size_t size, std::align_val_t align) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto alignment = static_cast<std::size_t>(align);
+#ifdef _WIN32
+    if (void* p = _aligned_malloc(std::max<std::size_t>(size, 1), alignment)) return p;
+#else
+    // aligned_alloc vyžaduje velikost dělitelnou zarovnáním
+    if (void* p = std::aligned_alloc(alignment, (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment))
+        return p;
+#endif
+    throw std::bad_alloc();
+}
+
+SEM_2_NOINLINE void operator delete(void* p, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+SEM_2_NOINLINE void operator delete(void* p, std::size_t, std::align_val_t align) noexcept {
+    ::operator delete(p, align);
+}
+
+// true, pokud standardní vstup je terminál (jinak jde o rouru nebo soubor -> dávkový režim)
+bool stdinIsTerminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdin)) != 0;
+#else
+    return isatty(STDIN_FILENO) != 0;
+#endif
+}
+
+/*
+ * Spuštění kalkulačky: na terminálu interaktivně, z roury nebo souboru dávkově
+ * (bez promptu a úvodního textu, s bufferovaným vstupem i výstupem).
+ * S neprázdným bank_path se historie ukládá do souboru a přežije další spuštění.
+ */
+template<size_t PRECISION>
+void runTerm(const std::string& title, const std::string& bank_path) {
+    MPTerm<PRECISION> term;
+    if (!bank_path.empty()) term.openBank(bank_path);
+    if (stdinIsTerminal()) {
+        std::cout << title << std::endl
+        << "Zadejte matematicky vyraz s operacemi +, -, *, /, %, ^, ! a zavorkami" << std::endl;
+        term.run();
+    }
+    else {
+        std::ios::sync_with_stdio(false);
+        term.runBatch();
+    }
+}
 
 void printModeHelp() {
     std::cout << "mode <1> pro neomezenou presnost." << std::endl;
     std::cout << "mode <2> pro presnost 32 bajtu." << std::endl;
     std::cout << "mode <3> pro ukazku knihovny." << std::endl;
+    std::cout << "mode <4> pro benchmark." << std::endl;
+    std::cout << "mode <5> pro paralelni davkove zpracovani vstupu (neomezena presnost)." << std::endl;
+    std::cout << "Rezimy 1, 2 a 5 berou volitelne i soubor banky pro trvalou historii: my_program.exe <mode> [banka]" << std::endl;
 }
 
 void printHeader(const std::string& title) {
@@ -204,6 +311,819 @@ void runTestSuite() {
             printResult(unlim2.toString() == "5100", "Unlimited += Limited (5000 + 100 = 5100)");
         }
 
+        // =============================================================
+        // 9. RYCHLÉ NÁSOBENÍ VELKÝCH ČÍSEL
+        // =============================================================
+        printHeader("9. Nasobeni velkych cisel (skolni / Karatsuba / Toom-3 / NTT)");
+        {
+            // po šesti umocněních na druhou má číslo přes 100 limbů
+            MPInt<0> base("123456789123456789123456789");
+            MPInt<0> a = base;
+            for (int i = 0; i < 6; ++i) a *= a;
+            MPInt<0> b = a + base;
+
+            const mpn::MulThresholds saved = mpn::mul_thresholds;
+            mpn::mul_thresholds = {SIZE_MAX, SIZE_MAX, SIZE_MAX};
+            const MPInt<0> school = a * b;
+            mpn::mul_thresholds = {8, SIZE_MAX, SIZE_MAX};
+            const MPInt<0> karatsuba = a * b;
+            mpn::mul_thresholds = {8, 16, SIZE_MAX};
+            const MPInt<0> toom = a * b;
+            mpn::mul_thresholds = {8, 16, 32};
+            const MPInt<0> ntt = a * b;
+            // prah Karatsuby pod 2 se bere jako 2 (jinak nekonečná rekurze)
+            mpn::mul_thresholds = {0, SIZE_MAX, SIZE_MAX, 1, SIZE_MAX};
+            const MPInt<0> tiny = a * b;
+            const MPInt<0> tiny_sqr = a * a;
+            mpn::mul_thresholds = saved;
+
+            printResult(school == karatsuba, "Karatsuba = skolni nasobeni");
+            printResult(school == toom, "Toom-3 = skolni nasobeni");
+            printResult(school == ntt, "NTT = skolni nasobeni");
+            printResult(tiny == school && tiny_sqr == a * a, "Karatsuba s prahem 0 a 1 limb");
+
+            // x * x jde přes umocnění na druhou, kopie přes obecné násobení
+            const MPInt<0> copy = a;
+            printResult(a * a == a * copy, "Druha mocnina = obecne nasobeni");
+        }
+
+        // =============================================================
+        // 10. FAKTORIÁL
+        // =============================================================
+        printHeader("10. Faktorial (strom soucinu, preteceni)");
+        {
+            MPInt<0> n("30");
+            printResult(n.factorial().toString() == "265252859812191058636308480000000", "30! = 265252859812191058636308480000000");
+
+            // 21! se do 8 bajtů nevejde, výjimka nese výsledek oříznutý na 64 bitů
+            MPInt<8> small("21");
+            try {
+                small.factorial();
+                printResult(false, "Melo pretect (21! do 8B)");
+            } catch (const MPInt<8>::OverflowException& e) {
+                printResult(e.getResult().toString() == "14197454024290336768", "Spravne oriznuti 21! na 8 bajtu");
+            }
+
+            // 10^6! se vůbec nepočítá, po oříznutí je to nula
+            MPInt<8> huge("1000000");
+            try {
+                huge.factorial();
+                printResult(false, "Melo pretect (1000000! do 8B)");
+            } catch (const MPInt<8>::OverflowException& e) {
+                printResult(e.getResult().toString() == "0", "Preteceni 1000000! zjisteno predem");
+            }
+        }
+
+        // =============================================================
+        // 11. OPERACE S NATIVNÍMI ČÍSLY
+        // =============================================================
+        printHeader("11. Operace s nativnimi cisly (int64_t, uint64_t)");
+        {
+            MPInt<0> a(-1234567890123LL);
+            printResult(a.toString() == "-1234567890123", "Konstruktor z long long");
+
+            a *= UINT64_MAX;
+            a += 5;
+            printResult(a.toString() == "-22773757910718555131242917198640", "-1234567890123 * (2^64 - 1) + 5");
+
+            const mpn::limb_t remainder = a.divRem(1000000007);
+            printResult(a.toString() == "-22773757751302250872127" && remainder == 161093751,
+                        "divRem vraci podil i zbytek");
+
+            MPInt<1> small(200);
+            try {
+                small += 100;
+                printResult(false, "Melo pretect (200 + 100 do 1B)");
+            } catch (const MPInt<1>::OverflowException& e) {
+                printResult(e.getResult().toString() == "44" && small.toString() == "200",
+                            "Preteceni 200 + 100 -> 44, puvodni hodnota nezmenena");
+            }
+        }
+
+        // =============================================================
+        // 12. MOCNINY A MODULÁRNÍ MOCNINY
+        // =============================================================
+        printHeader("12. Mocniny (posuvne okno, Montgomery, Barrett)");
+        {
+            MPInt<0> three(3);
+            printResult(three.pow(100).toString() == "515377520732011331036461129765621272702107522001",
+                        "3^100 (Unlimited)");
+
+            // velký exponent, porovnání s opakovaným násobením
+            const MPInt<0> base("123456789123456789");
+            MPInt<0> product(1);
+            for (int i = 0; i < 300; ++i) product *= base;
+            printResult(pow(base, 300) == product, "base^300 = opakovane nasobeni");
+            printResult(MPInt<0>(-2).pow(3).toString() == "-8", "(-2)^3 = -8");
+
+            MPInt<8> small(3);
+            printResult(small.pow(40).toString() == "12157665459056928801", "3^40 se vejde do 8B");
+            try {
+                small.pow(41);
+                printResult(false, "Melo pretect (3^41 do 8B)");
+            } catch (const MPInt<8>::OverflowException& e) {
+                printResult(e.getResult().toString() == "18026252303461234787", "Spravne oriznuti 3^41 na 8 bajtu");
+            }
+
+            printResult(powmod(MPInt<4>(4), MPInt<4>(13), MPInt<4>(497)).toString() == "445", "4^13 mod 497 = 445");
+            printResult(MPInt<4>(-2).powmod(MPInt<4>(3), MPInt<4>(5)).toString() == "2", "(-2)^3 mod 5 = 2");
+
+            const MPInt<0> a("123456789123456789123456789");
+            const MPInt<0> e("18446744073709551613");
+            const MPInt<0> odd_mod = MPInt<0>(2).pow(200) + MPInt<0>(12345);
+            printResult(a.powmod(e, odd_mod).toString() ==
+                        "955486409373272936960956054835376986381040155301482529372904",
+                        "Lichy modul (Montgomery)");
+            printResult(a.powmod(e, odd_mod * MPInt<0>(2)).toString() ==
+                        "2562424453632263212502918147176539588903243149084275364686625",
+                        "Sudy modul (Barrett)");
+        }
+
+        // =============================================================
+        // 13. VÝRAZY (PRIORITY, ZÁVORKY, BYTEKÓD)
+        // =============================================================
+        printHeader("13. Vyrazy prelozene do bytekodu");
+        {
+            std::vector<std::string_view> tokens;
+            std::vector<MPInt<0>> registers;
+            auto noHistory = [](size_t) -> const MPInt<0>& { throw std::invalid_argument("prazdna historie"); };
+            auto eval = [&](std::string_view line) {
+                MPTerm<0>::tokenize(line, tokens);
+                return MPExpr<0>::compile(tokens).evaluate(registers, noHistory).toString();
+            };
+
+            printResult(eval("(2 + 3) * 4 - 3 !") == "14", "(2 + 3) * 4 - 3! = 14");
+            printResult(eval("2 ^ 3 ^ 2") == "512", "^ je zprava asociativni (2^9)");
+            printResult(eval("2 * -(3 + 4) ^ 2") == "-98", "Unarni minus pred zavorkou");
+            printResult(eval("-2 ^ 2") == "-4" && eval("-3 !") == "-6" && eval("2 * -3") == "-6",
+                        "Unarni minus ma nizsi prioritu nez ^ a ! (-2^2 = -4, -3! = -6)");
+            printResult(eval("100 - 10 - 1") == "89" && eval("17 % 5 * 2") == "4", "Zleva asociativni operatory");
+
+            // jeden přeložený výraz, opakované vyhodnocení nad jinou historií
+            std::array<MPInt<0>, 2> bank = {MPInt<0>(10), MPInt<0>(3)};
+            auto lookup = [&](size_t index) -> const MPInt<0>& { return bank.at(index); };
+            MPTerm<0>::tokenize("($1 + 1) * $2", tokens);
+            const MPExpr<0> expr = MPExpr<0>::compile(tokens);
+            const bool first = expr.evaluate(registers, lookup).toString() == "33";
+            bank[0] = MPInt<0>(100);
+            printResult(first && expr.evaluate(registers, lookup).toString() == "303", "Opakovane vyhodnoceni s historii");
+
+            // ^ do % je jedna modulární mocnina, ať je výraz zapsaný jakkoli
+            std::array<MPInt<0>, 1> minus_two = {MPInt<0>(-2)};
+            auto evalMinusTwo = [&](std::string_view line) {
+                MPTerm<0>::tokenize(line, tokens);
+                return MPExpr<0>::compile(tokens).evaluate(registers, [&](size_t i) -> const MPInt<0>& {
+                    return minus_two.at(i);
+                }).toString();
+            };
+            printResult(evalMinusTwo("$1 ^ 3 % 5") == "-3" && evalMinusTwo("($1 ^ 3) % 5") == "-3" &&
+                        evalMinusTwo("$1 ^ 3 % 5 * 1") == "-3" && eval("-8 % 5") == "-3",
+                        "$1 ^ 3 % 5 = ($1 ^ 3) % 5 = $1 ^ 3 % 5 * 1 = -8 % 5 ($1 = -2)");
+            printResult(evalMinusTwo("$1 ^ 2 % 5") == "4" && eval("2 ^ 3 ^ 2 % 5") == "2" &&
+                        eval("7 ^ 2 % (10 + (5 * (1 + 1)))") == "9", "Znamenko, ^ zprava a slozeny modul");
+            MPTerm<0>::tokenize("(2 ^ 3) % 5", tokens);
+            const bool fused = std::ranges::any_of(MPExpr<0>::compile(tokens).instructions(),
+                                                   [](const auto& in) { return in.op == MPExpr<0>::Op::PowMod; });
+            MPTerm<0>::tokenize("2 ^ 3 * 1 % 5", tokens);
+            const bool not_fused = std::ranges::none_of(MPExpr<0>::compile(tokens).instructions(),
+                                                        [](const auto& in) { return in.op == MPExpr<0>::Op::PowMod; });
+            printResult(fused && not_fused, "PowMod jen kdyz vysledek ^ jde primo do %");
+
+            // omezená přesnost: mocnina do % nepřeteče v žádném zápisu
+            std::vector<MPInt<32>> registers32;
+            auto eval32 = [&](std::string_view line) {
+                MPTerm<32>::tokenize(line, tokens);
+                return MPExpr<32>::compile(tokens).evaluate(registers32, [](size_t) -> const MPInt<32>& {
+                    throw std::invalid_argument("prazdna historie");
+                }).toString();
+            };
+            printResult(eval32("2 ^ 300 % 7") == "1" && eval32("(2 ^ 300) % 7") == "1" && eval32("2 ^ 300 % 7 + 0") == "1",
+                        "MPInt<32>: 2 ^ 300 % 7 = (2 ^ 300) % 7 = 1");
+
+            // hluboké zanoření skončí chybou, ne přetečením zásobníku; dlouhý plochý řetěz projde
+            auto nested = [](size_t n) { return std::string(n, '(') + "1" + std::string(n, ')'); };
+            auto negations = [](size_t n) {
+                std::string line;
+                for (size_t i = 0; i < n; ++i) line += "- ";
+                return line + "1";
+            };
+            std::string flat = "1";
+            for (int i = 0; i < 5000; ++i) flat += " + 1";
+            printResult(eval(nested(500)) == "1" && eval(negations(501)) == "-1" && eval(flat) == "5001",
+                        "500 zavorek, 501 unarnich minus a 5001 scitancu");
+            bool too_deep = true;
+            std::string powers = "1";
+            for (int i = 0; i < 20000; ++i) powers += " ^ 1";
+            for (const std::string& line : {nested(50000), negations(100000), powers}) {
+                try {
+                    eval(line);
+                    too_deep = false;
+                } catch (const std::invalid_argument& e) {
+                    too_deep = too_deep && std::string(e.what()) == "Expression is nested too deeply";
+                }
+            }
+            printResult(too_deep, "50000 zavorek, 100000 unarnich minus, 20000x ^: Expression is nested too deeply");
+
+            try {
+                eval("(1 + 2");
+                printResult(false, "Mela nastat syntakticka chyba");
+            } catch (const std::invalid_argument& e) {
+                printResult(true, std::string("Zachyceno: ") + e.what());
+            }
+        }
+
+        // =============================================================
+        // 14. LÍNÉ VÝRAZY (EXPRESSION TEMPLATES)
+        // =============================================================
+        printHeader("14. Line vyrazy (jeden pruchod pro +/-, nasobeni s akumulaci)");
+        {
+            const MPInt<0> a("123456789012345678901234567890");
+            const MPInt<0> b("-98765432109876543210");
+            const MPInt<0> c("5");
+            const MPInt<0> d("1000000000000000000000000000000");
+
+            const MPInt<0> chain = a + b + c - d;
+            printResult(chain.toString() == "-876543211086419753208641975315", "a + b + c - d");
+
+            const MPInt<0> mac = a * b + c;
+            printResult(mac.toString() == "-12193263113702179522496570642237463801111263526895",
+                        "a * b + c (nasobeni s akumulaci)");
+
+            MPInt<0> acc = d;
+            acc -= a * c;
+            printResult(acc.toString() == "382716054938271605493827160550", "acc -= a * c");
+
+            // omezená přesnost: přetečení se pozná až na výsledku
+            const MPInt<1> x(200), y(100), z(150);
+            const MPInt<1> fits = x + y - z;
+            printResult(fits.toString() == "150", "200 + 100 - 150 se do 1B vejde");
+            try {
+                const MPInt<1> over = x * y + z;
+                (void)over;
+                printResult(false, "Melo pretect (200 * 100 + 150 do 1B)");
+            } catch (const MPInt<1>::OverflowException& e) {
+                printResult(e.getResult().toString() == "182", "Spravne oriznuti 20150 na 1 bajt");
+            }
+
+            // více součinů na každé straně (další součiny v odkládací aréně)
+            MPInt<0> sum = a * b;
+            sum += c * d;
+            sum -= a * a;
+            sum -= b * d;
+            const MPInt<0> products = a * b + c * d - a * a - b * d;
+            const MPInt<64> products64 = MPInt<64>(a) * MPInt<64>(b) + MPInt<64>(c) * MPInt<64>(d) - MPInt<64>(a) * MPInt<64>(a) - MPInt<64>(b) * MPInt<64>(d);
+            printResult(products == sum && products64 == MPInt<64>(sum), "a * b + c * d - a * a - b * d (MPInt<0> i MPInt<64>)");
+
+            // výraz jde použít tam, kde se dřív psalo s hotovým MPInt
+            printResult((c + c).toString() == "10" && (c * c).toHex() == "19", "(c + c).toString(), (c * c).toHex()");
+            printResult(pow(c + c, 3).toString() == "1000" && (c * c).pow(2).toString() == "625", "pow(c + c, 3), (c * c).pow(2)");
+            printResult(c.powmod(c + c, d * MPInt<0>(2)) == MPInt<0>(9765625) &&
+                        powmod(c + c, c, d - a) == MPInt<0>(100000), "powmod s vyrazem v zakladu, exponentu i modulu");
+            MPInt<0> q = d;
+            q /= c + c;
+            q %= a - b;
+            printResult(q == MPInt<0>("100000000000000000000000000000") % (a - b).eval(), "q /= c + c; q %= a - b");
+        }
+
+        // =============================================================
+        // 15. PLATNÁ DÉLKA LIMITED ČÍSEL
+        // =============================================================
+        printHeader("15. Male hodnoty ve velke presnosti (jen platne limby)");
+        {
+            MPInt<4096> a(5), b(7);
+            a *= b;
+            printResult(a.toString() == "35", "MPInt<4096>: 5 * 7 = 35");
+            printResult(a.getDataOnPos(0) == 35 && a.getDataOnPos(4095) == 0, "Bajty nad platnou delkou jsou 0");
+
+            a -= MPInt<4096>(35);
+            printResult(a.toString() == "0" && !a.getNegative(), "35 - 35 = 0 (kladna nula)");
+
+            // číslo přes celou přesnost a zpět na malé
+            MPInt<16> full("340282366920938463463374607431768211455");   // 2^128 - 1
+            MPInt<16> one(1);
+            try {
+                full += one;
+                printResult(false, "Melo pretect (2^128 - 1 + 1)");
+            } catch (const MPInt<16>::OverflowException& e) {
+                printResult(e.getResult().toString() == "0", "Preteceni na 0");
+            }
+            full -= MPInt<16>("340282366920938463463374607431768211450");
+            printResult(full.toString() == "5", "(2^128 - 1) - (2^128 - 6) = 5");
+            full *= 3;
+            printResult(full.toString() == "15" && full < MPInt<16>(16), "5 * 3 = 15, porovnani s malym cislem");
+
+            // součin -2^64 * 2^64 = -2^128: oříznutí nechá samé nuly, výsledek je kladná nula
+            const MPInt<16> a64("18446744073709551616"), m64("-18446744073709551616");
+            MPInt<16> z = m64;
+            try {
+                z *= a64;
+                printResult(false, "Melo pretect (-2^64 * 2^64)");
+            } catch (const MPInt<16>::OverflowException& e) {
+                const MPInt<16>& r = e.getResult();
+                printResult(r == MPInt<16>(0) && r.toString() == "0" && !r.getNegative(),
+                            "Preteceni -2^128 na nulu bez znamenka");
+            }
+        }
+
+        // =============================================================
+        // 16. UNLIMITED S VNITŘNÍM BUFFEREM
+        // =============================================================
+        printHeader("16. Unlimited cisla s vnitrnim bufferem (bez alokace do 4 limbu)");
+        {
+            // 2^64 - 1 se opakovaným násobením dostane přes 4 limby (na haldu) a dělením zpět
+            const MPInt<0> word("18446744073709551615");
+            MPInt<0> x = word;
+            for (int i = 0; i < 7; ++i) x *= word;
+            printResult(x.toString().size() == 155, "(2^64 - 1)^8 ma 155 cifer (8 limbu)");
+
+            MPInt<0> moved = std::move(x);
+            for (int i = 0; i < 7; ++i) moved /= word;
+            printResult(moved == word, "Po presunu a deleni zpet na 2^64 - 1");
+
+            MPInt<0> small(-42);
+            MPInt<0> copy = small;
+            small = std::move(moved);
+            printResult(copy.toString() == "-42" && small == word, "Kopie a presun malych hodnot");
+        }
+
+        // =============================================================
+        // 17. ODKLÁDACÍ ARÉNA A VLASTNÍ ZDROJ PAMĚTI
+        // =============================================================
+        printHeader("17. Odkladaci arena a vlastni zdroj pameti (std::pmr)");
+        {
+            // aréna se po výpočtech s velkými mezivýsledky vrátí do prázdného stavu
+            mpn::ScratchArena& arena = mpn::ScratchArena::local();
+            const MPInt<0> big = MPInt<0>(3000).factorial(1);
+            const std::string text = big.toString();
+            const MPInt<0> parsed(text);
+            printResult(parsed == big && (parsed * parsed) / big == big && arena.inUse() == 0,
+                        "3000! pres arenu: tisk, nacteni, nasobeni a deleni, arena je pak prazdna");
+
+            // počítadlo bloků přidělených zdrojem, data bere z monotónní paměti
+            struct CountingResource : std::pmr::memory_resource {
+                std::pmr::monotonic_buffer_resource upstream;
+                size_t allocated = 0, deallocated = 0;
+                void* do_allocate(std::size_t bytes, std::size_t align) override {
+                    ++allocated;
+                    return upstream.allocate(bytes, align);
+                }
+                void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+                    ++deallocated;
+                    upstream.deallocate(p, bytes, align);
+                }
+                bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                    return this == &other;
+                }
+            } resource;
+
+            const MPInt<0> word("18446744073709551615");
+            MPInt<0> outside = word;
+            {
+                mpn::LimbResourceScope scope(&resource);
+                MPInt<0> inside = word;
+                for (int i = 0; i < 9; ++i) inside *= word;
+                outside = inside;      // kopie do existující hodnoty alokuje také ze zdroje
+                inside /= word.pow(9);
+                printResult(inside == word && mpn::limbResource() == &resource && resource.allocated > 0,
+                            "Velke hodnoty v rozsahu alokuji ze zadaneho zdroje");
+            }
+            const size_t after_scope = resource.allocated;
+            MPInt<0> later = outside * outside;
+            printResult(mpn::limbResource() == std::pmr::new_delete_resource() && resource.allocated == after_scope,
+                        "Po skonceni rozsahu se alokuje zase z haldy");
+            outside = later;
+            printResult(resource.deallocated == resource.allocated && later.toString().size() == 386,
+                        "Bloky ze zdroje se vrati do zdroje i mimo rozsah");
+        }
+
+        // =============================================================
+        // 18. VEKTOROVÁ JÁDRA
+        // =============================================================
+        printHeader("18. Vektorova jadra scitani, odcitani a porovnani");
+        {
+            std::mt19937_64 gen(18);
+            auto randomDigits = [&](size_t digits) {
+                std::string s;
+                for (size_t i = 0; i < digits; ++i) s.push_back(static_cast<char>('1' + gen() % 9));
+                return s;
+            };
+            // 2^8000 - 1: přenos z nejnižšího limbu projde všemi pruhy i bloky
+            const MPInt<8192> power = MPInt<8192>(2).pow(8000);
+            const MPInt<8192> ones = power - MPInt<8192>(1);
+            const MPInt<8192> a(randomDigits(2400)), b(randomDigits(2300));
+            MPInt<8192> almost = a;
+            almost += MPInt<8192>(1);
+
+            auto text = [](const MPInt<8192>& x) { return x.toString(); };
+            auto run = [&] {
+                std::vector<std::string> out;
+                out.push_back(text(ones + MPInt<8192>(1)));
+                out.push_back(text(a + b));
+                out.push_back(text(a - b));
+                out.push_back(text(b - a));
+                out.push_back(text(power - ones));
+                out.push_back(std::to_string(a < almost) + std::to_string(almost > a) +
+                              std::to_string(a == MPInt<8192>(a)) + std::to_string(ones < power));
+                return out;
+            };
+            const mpn::simd::Level best = mpn::simd::level();
+            mpn::simd::setLevel(mpn::simd::Level::Scalar);
+            const std::vector<std::string> scalar = run();
+            mpn::simd::setLevel(best);
+            const std::vector<std::string> vector = run();
+
+            printResult(scalar == vector, std::string("Uroven ") + mpn::simd::levelName(best) +
+                                          " dava stejne vysledky jako skalarni kod");
+            printResult(vector[0] == power.toString() && vector[4] == "1" && vector[5] == "1111",
+                        "Prenos a vypujcka pres vsechny limby, porovnani lisicich se v nejnizsim limbu");
+        }
+
+        printHeader("19. Davka cisel MPIntBatch (sloupcove ulozeni)");
+        {
+            std::mt19937_64 gen(19);
+            // MPInt<16>: dva limby, délky se míchají, aby některé výsledky přetekly
+            std::vector<MPInt<16>> xs, ys;
+            for (size_t i = 0; i < 203; ++i) {
+                auto random = [&] {
+                    std::string s = gen() % 2 ? "-" : "";
+                    // čtvrtina čísel těsně pod 2^128 (39 cifer), jejich součty přetečou
+                    const bool large = gen() % 4 == 0;
+                    if (large) s += "33";
+                    const size_t digits = large ? 37 : 1 + gen() % 38;
+                    for (size_t k = 0; k < digits; ++k) s.push_back(static_cast<char>('1' + gen() % 9));
+                    return MPInt<16>(s);
+                };
+                xs.push_back(random());
+                ys.push_back(i % 7 == 0 ? xs.back() : random());
+            }
+            // referenční výsledek po jednom, při přetečení oříznutá hodnota z výjimky
+            auto reference = [&](size_t i, int op, bool& over) {
+                MPInt<16> r = xs[i];
+                over = false;
+                try {
+                    if (op == 0) r += ys[i];
+                    else if (op == 1) r -= ys[i];
+                    else r *= ys[i];
+                } catch (const MPInt<16>::OverflowException& e) {
+                    r = e.getResult();
+                    over = true;
+                }
+                return r;
+            };
+
+            const MPIntBatch<16> a{std::span<const MPInt<16>>(xs)}, b{std::span<const MPInt<16>>(ys)};
+            MPIntBatch<16> r;
+            std::vector<std::uint8_t> overflow;
+            const char* names[] = {"Scitani", "Odcitani", "Nasobeni"};
+            for (int op = 0; op < 3; ++op) {
+                const size_t count = op == 0 ? r.add(a, b, overflow) : op == 1 ? r.sub(a, b, overflow) : r.mul(a, b, overflow);
+                bool same = r.size() == xs.size();
+                size_t expected = 0;
+                for (size_t i = 0; same && i < xs.size(); ++i) {
+                    bool over = false;
+                    const MPInt<16> value = reference(i, op, over);
+                    same = r.get(i) == value && overflow[i] == over && r.get(i).getNegative() == value.getNegative();
+                    expected += over;
+                }
+                printResult(same && count == expected && expected > 0,
+                            std::string(names[op]) + " odpovida MPInt vcetne " + std::to_string(count) + " preteceni");
+            }
+
+            std::vector<std::int8_t> order;
+            MPIntBatch<16>::compare(a, b, order);
+            bool ordered = order.size() == xs.size();
+            for (size_t i = 0; ordered && i < xs.size(); ++i) {
+                ordered = order[i] == (xs[i] < ys[i] ? -1 : xs[i] == ys[i] ? 0 : 1);
+            }
+            printResult(ordered, "Porovnani po prvcich odpovida <, ==");
+
+            // výsledek do operandu, x - x je vždy kladná nula
+            MPIntBatch<16> x = a;
+            x.sub(x, x, overflow);
+            bool zeros = true;
+            for (size_t i = 0; i < x.size(); ++i) zeros = zeros && x.get(i) == MPInt<16>(0) && !x.get(i).getNegative();
+            printResult(zeros, "Vysledek do operandu: x - x = 0 bez zaporne nuly");
+
+            x.resize(5);
+            x.resize(9);
+            printResult(x.size() == 9 && x.get(7) == MPInt<16>(0), "Zmena velikosti doplni nuly");
+
+            bool thrown = false;
+            try {
+                r.add(a, x, overflow);
+            } catch (const std::invalid_argument&) {
+                thrown = true;
+            }
+            printResult(thrown, "Ruzne velke davky vyhodi std::invalid_argument");
+        }
+
+        printHeader("20. Aritmetika bez vyjimek (Overflow::Wrap, checkedAdd/Sub/Mul/Pow)");
+        {
+            // 2^128 - 1, maximum pro MPInt<16>
+            const MPInt<16> max("340282366920938463463374607431768211455");
+            const MPInt<16> one(1);
+
+            const Checked<16> sum = checkedAdd(max, one);
+            printResult(sum.overflow && sum.value == MPInt<16>(0), "checkedAdd(max, 1) -> 0 s priznakem preteceni");
+
+            MPInt<16> min = max;
+            min.negate();
+            const Checked<16> diff = checkedSub(min, 2);
+            printResult(diff.overflow && diff.value.toString() == "-1", "checkedSub(-max, 2) -> -1 (absolutni hodnota modulo 2^128)");
+
+            const Checked<16> fits = checkedMul(MPInt<16>("18446744073709551615"), MPInt<16>(-3));
+            printResult(!fits.overflow && fits.value.toString() == "-55340232221128654845", "checkedMul bez preteceni vrati presny vysledek");
+
+            const Checked<16> power = checkedPow(MPInt<16>(2), 130);
+            printResult(power.overflow && power.value == MPInt<16>(0), "checkedPow(2, 130) -> 0 s priznakem preteceni");
+
+            // Wrap dává stejný oříznutý výsledek, jaký nese výjimka
+            MPInt<16> wrapped = max;
+            const bool flag = wrapped.mul<Overflow::Wrap>(max);
+            MPInt<16> thrown = max;
+            bool same = false;
+            try {
+                thrown *= max;
+            } catch (const MPInt<16>::OverflowException& e) {
+                same = e.getResult() == wrapped && thrown == max;
+            }
+            printResult(flag && same && wrapped == one, "max * max: Wrap = vysledek vyjimky, Throw necha cislo beze zmeny");
+
+            MPInt<0> unlimited = max;
+            printResult(!unlimited.add<Overflow::Wrap>(max) && unlimited.toString() == "680564733841876926926749214863536422910",
+                        "Unlimited nikdy nepretece");
+        }
+
+        printHeader("21. Vypocty pri prekladu (constexpr, literal _mp)");
+        {
+            // všechno níže se spočítá při překladu, za běhu se jen porovnávají hotové konstanty
+            constexpr auto small = 12345678901234567890_mp;
+            constexpr auto large = 98'765'432'109'876'543'210_mp;
+            static_assert(std::is_same_v<std::remove_const_t<decltype(small)>, MPInt<8>>);
+            static_assert(std::is_same_v<std::remove_const_t<decltype(large)>, MPInt<16>>);
+
+            constexpr MPInt<32> product = MPInt<32>(small) * large + 1_mp;
+            constexpr MPInt<32> fact = [] {
+                MPInt<32> x(1);
+                for (int i = 2; i <= 30; ++i) x *= i;
+                return x;
+            }();
+            constexpr MPInt<16> quotient = [] {
+                MPInt<16> x = 1'000'000'000'000'000'000'000_mp;
+                x /= 7;
+                return x;
+            }();
+            constexpr MPInt<16> negative = -5_mp - large;
+            static_assert(product > large && negative < 0_mp);
+
+            printResult(small.toString() == "12345678901234567890" && large.toString() == "98765432109876543210",
+                        "Literal _mp vybere nejmensi presnost (MPInt<8>, MPInt<16>)");
+            printResult(product == MPInt<32>("1219326311370217952237463801111263526901"),
+                        "Lazy vyraz small * large + 1 vyhodnoceny pri prekladu");
+            printResult(fact == MPInt<0>(30).factorial(), "30! smyckou *= pri prekladu");
+            printResult(quotient.toString() == "142857142857142857142" && negative.toString() == "-98765432109876543215",
+                        "Deleni nativnim cislem a zaporny literal pri prekladu");
+
+            constexpr Checked<16> wrapped = checkedAdd(MPInt<16>(340282366920938463463374607431768211455_mp), 1);
+            static_assert(wrapped.overflow);
+            printResult(wrapped.value == MPInt<16>(0), "checkedAdd s pretecenim pri prekladu");
+        }
+
+        printHeader("22. Sestnactkovy zapis a binarni format (serialize, MPIntView)");
+        {
+            const MPInt<0> big = MPInt<0>(200).factorial();
+            const MPInt<16> max("340282366920938463463374607431768211455");
+            printResult(max.toHex() == std::string(32, 'f') && MPInt<0>(-255).toHex() == "-ff" && MPInt<0>().toHex() == "0",
+                        "toHex: mala pismena, znamenko, nula");
+            printResult(MPInt<0>::fromHex(big.toHex()) == big && MPInt<0>::fromHex("-0x1F") == MPInt<0>(-31)
+                        && MPInt<8>::fromHex("+00000000000000000000ff") == MPInt<8>(255),
+                        "fromHex: zpetny prevod 200!, predpona 0x, uvodni nuly");
+            static_assert(MPInt<8>::fromHex("0xFFFFFFFFFFFFFFFF") == 18446744073709551615_mp);
+
+            bool invalid = false;
+            try {
+                MPInt<0>::fromHex("0x12g4");
+            } catch (const std::invalid_argument&) {
+                invalid = true;
+            }
+            bool overflow = false;
+            try {
+                MPInt<4>::fromHex("100000000");
+            } catch (const MPInt<4>::OverflowException&) {
+                overflow = true;
+            }
+            printResult(invalid && overflow && MPInt<4>::fromHex("0000ffffffff") == MPInt<4>(4294967295u),
+                        "fromHex: neplatny znak a preteceni MPInt<4>");
+
+            // více čísel za sebou do jednoho bufferu, limby zůstanou zarovnané na 8 bajtů
+            const std::vector<MPInt<0>> values = {MPInt<0>(0), MPInt<0>(-1), MPInt<0>("18446744073709551616"), -big};
+            size_t total = 0;
+            for (const auto& v : values) total += v.serializedSize();
+            std::vector<std::byte> buffer(total);
+            size_t offset = 0;
+            for (const auto& v : values) offset += v.serialize(std::span(buffer).subspan(offset));
+            printResult(offset == total && total == 4 * 8 + (0 + 1 + 2) * 8 + big.serializedSize() - 8,
+                        "serialize: hlavicka 8 bajtu + 8 bajtu na limb");
+
+            bool copies = true, views = true;
+            offset = 0;
+            for (const auto& v : values) {
+                const std::span<const std::byte> rest = std::span<const std::byte>(buffer).subspan(offset);
+                const MPIntView view = MPIntView::deserialize(rest);
+                copies = copies && MPInt<0>::deserialize(rest) == v;
+                views = views && MPInt<0>(view) == v && view.toString() == v.toString()
+                        && view.limbs().data() == reinterpret_cast<const mpn::limb_t*>(rest.data() + 8);
+                offset += view.serializedSize();
+            }
+            printResult(copies && views, "deserialize (kopie) i MPIntView (limby primo v bufferu)");
+
+            const MPIntView last = MPIntView::deserialize(std::span<const std::byte>(buffer).subspan(total - (-big).serializedSize()));
+            const MPInt<0> sum = last + big + MPInt<0>(7);
+            printResult(sum == MPInt<0>(7) && last < MPInt<0>(0) && last.toHex() == (-big).toHex(), "MPIntView v linem vyrazu a porovnani");
+
+            bool small = false;
+            try {
+                std::array<std::byte, 8> tiny{};
+                big.serialize(tiny);
+            } catch (const std::invalid_argument&) {
+                small = true;
+            }
+            bool truncated = false;
+            try {
+                MPInt<0>::deserialize(std::span<const std::byte>(buffer).subspan(total - 16));
+            } catch (const std::invalid_argument&) {
+                truncated = true;
+            }
+            bool limited = false;
+            try {
+                MPInt<16>::deserialize(std::span<const std::byte>(buffer).subspan(total - (-big).serializedSize()));
+            } catch (const MPInt<16>::OverflowException& e) {
+                // 200! je dělitelný 2^197, takže -200! modulo 2^128 je kladná nula
+                limited = e.getResult() == MPInt<16>(0) && !e.getResult().getNegative();
+            }
+            printResult(small && truncated && limited, "Maly buffer, useknuta data a preteceni MPInt<16>");
+
+            // -2^128 do MPInt<16>: oříznutí na nulu, výsledek jde znovu zapsat a přečíst
+            const MPInt<0> minus = MPInt<0>(0) - MPInt<0>(2).pow(128);
+            std::vector<std::byte> record(minus.serializedSize());
+            minus.serialize(record);
+            bool zero = false;
+            try {
+                MPInt<16>::deserialize(record);
+            } catch (const MPInt<16>::OverflowException& e) {
+                const MPInt<16>& r = e.getResult();
+                std::vector<std::byte> again(r.serializedSize());
+                r.serialize(again);
+                zero = r == MPInt<16>(0) && !r.getNegative() && again.size() == 8
+                       && MPInt<16>::deserialize(again) == MPInt<16>(0);
+            }
+            printResult(zero, "Preteceni -2^128 pri cteni: kladna nula, zapis bez nulovych limbu");
+
+            // posunutý buffer: kopie funguje, view bez zarovnání odmítne
+            std::vector<std::byte> shifted(total + 4);
+            std::copy(buffer.begin(), buffer.end(), shifted.begin() + 4);
+            const std::span<const std::byte> odd = std::span<const std::byte>(shifted).subspan(4 + 8);
+            bool unaligned = false;
+            try {
+                MPIntView::deserialize(odd);
+            } catch (const std::invalid_argument&) {
+                unaligned = true;
+            }
+            printResult(unaligned && MPInt<0>::deserialize(odd) == MPInt<0>(-1), "Nezarovnany buffer: kopie ano, view vyjimka");
+        }
+
+        printHeader("23. Trvala historie v souboru (HistoryBank, MPTerm::openBank)");
+        {
+            const std::filesystem::path dir = std::filesystem::temp_directory_path();
+            const std::string path = (dir / "sem_2_test.bank").string();
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".idx");
+
+            // hodnoty kolem 40 kB, aby soubor několikrát narostl (první krok je 1 MiB)
+            std::vector<MPInt<0>> values;
+            for (int i = 0; i < 60; ++i) {
+                MPInt<0> v = MPInt<0>(3).pow(200000 + 1000 * i);
+                if (i % 3 == 1) v.negate();
+                values.push_back(i % 7 == 0 ? MPInt<0>(i) : v);
+            }
+            bool same = true, stable = true;
+            {
+                HistoryBank bank(path);
+                bank.append(values[0]);
+                const MPIntView first = bank[0];
+                const mpn::limb_t* first_limbs = first.limbs().data();
+                for (size_t i = 1; i < values.size(); ++i) bank.append(values[i]);
+                for (size_t i = 0; i < values.size(); ++i) same = same && MPInt<0>(bank[i]) == values[i];
+                // view z doby před růstem souboru pořád ukazuje na stejné místo
+                stable = first.limbs().data() == first_limbs && MPInt<0>(first) == values[0];
+                same = same && MPInt<0>(bank.recent(0)) == values.back() && bank.size() == values.size();
+            }
+            printResult(same && stable, "append a cteni bez kopie, view plati i po rustu souboru");
+
+            size_t data_size = 0;
+            for (const auto& v : values) data_size += v.serializedSize();
+            bool reopened = false;
+            {
+                HistoryBank bank(path);
+                reopened = bank.size() == values.size() && MPInt<0>(bank[5]) == values[5] && bank.recent(1) == values[58];
+            }
+            printResult(reopened && std::filesystem::file_size(path) == 8 + data_size
+                        && std::filesystem::file_size(path + ".idx") == 8 * (2 + values.size()),
+                        "Po znovuotevreni jsou vysledky zpet, soubory zkracene na skutecnou delku");
+
+            // dvě sezení terminálu nad jednou bankou, výstup jde do stringu
+            auto session = [&](const std::string& input) {
+                std::ostringstream out;
+                std::istringstream in(input);
+                std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+                {
+                    MPTerm<0> term;
+                    term.openBank(path);
+                    term.runBatch(in);
+                }
+                std::cout.rdbuf(saved);
+                return out.str();
+            };
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".idx");
+            const std::string first = session("2 ^ 100\n$1 + 1\n");
+            const std::string second = session("$1 - $2\n$2 * 2\n$7\n");
+            printResult(first == "$1 = 1267650600228229401496703205376\n$1 = 1267650600228229401496703205377\nKoncim.\n"
+                        && second.starts_with("$1 = 1\n$1 = 2535301200456458802993406410754\n")
+                        && second.find("Neplatn") != std::string::npos,
+                        "MPTerm: $N sahne do vysledku predchoziho spusteni");
+
+            // přetečení v MPInt<32> uloží oříznutou nulu, banka zůstane čitelná i po znovuotevření
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".idx");
+            {
+                std::ostringstream out;
+                std::istringstream in("340282366920938463463374607431768211456 * 340282366920938463463374607431768211456\n$1 + 1\n");
+                std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+                {
+                    MPTerm<32> term;
+                    term.openBank(path);
+                    term.runBatch(in);
+                }
+                std::cout.rdbuf(saved);
+                HistoryBank bank(path);
+                printResult(out.str().find("$1 = 1\n") != std::string::npos && bank.size() == 2
+                            && MPInt<0>(bank.recent(1)) == MPInt<0>(0) && MPInt<0>(bank.recent(0)) == MPInt<0>(1),
+                            "Preteceny vysledek MPInt<32> jde do banky jako platna nula");
+            }
+
+            // poškozený offset uprostřed indexu: otevření projde, čtení záznamu vyhodí výjimku
+            {
+                std::fstream index(path + ".idx", std::ios::binary | std::ios::in | std::ios::out);
+                const std::uint64_t bad = std::uint64_t{1} << 40;
+                index.seekp(8 * 2);
+                index.write(reinterpret_cast<const char*>(&bad), sizeof(bad));
+            }
+            bool bad_offset = false;
+            try {
+                HistoryBank bank(path);
+                const MPIntView ok = bank[1];
+                bad_offset = MPInt<0>(ok) == MPInt<0>(1);
+                bank[0];
+                bad_offset = false;
+            } catch (const std::runtime_error&) {
+            }
+            printResult(bad_offset, "Offset za koncem dat vyhodi std::runtime_error misto cteni mimo soubor");
+
+            // cizí soubor se neotevře a zůstane beze změny
+            {
+                std::ofstream garbage(path + ".idx", std::ios::binary | std::ios::trunc);
+                garbage << "neni to banka";
+            }
+            bool rejected = false;
+            try {
+                HistoryBank bank(path);
+            } catch (const std::runtime_error&) {
+                rejected = true;
+            }
+            printResult(rejected && std::filesystem::file_size(path + ".idx") == 13, "Poskozeny index vyhodi std::runtime_error");
+            std::filesystem::remove(path);
+            std::filesystem::remove(path + ".idx");
+        }
+
+        printHeader("24. Pool vlaken s kradenim prace (kazdy index prave jednou)");
+        {
+            // pár pomalých položek vynutí kradení, každý index se musí zavolat právě jednou
+            WorkStealingPool pool(4);
+            bool exact = true;
+            for (const size_t grain : {1, 3, 16}) {
+                for (int run = 0; run < 3; ++run) {
+                    std::vector<std::atomic<int>> calls(1000);
+                    pool.parallelFor(calls.size(), [&](unsigned, size_t i) {
+                        if (i % 97 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                        calls[i].fetch_add(1, std::memory_order_relaxed);
+                    }, grain);
+                    exact = exact && std::ranges::all_of(calls, [](const std::atomic<int>& c) { return c.load() == 1; });
+                }
+            }
+            printResult(exact, "parallelFor(1000) s grain 1, 3, 16: zadny index dvakrat ani vynechany");
+        }
+
         std::cout << "\n========================================\n";
         std::cout << " VSECHNY TESTY DOKONCENY\n";
         std::cout << "========================================\n";
@@ -212,35 +1132,502 @@ void runTestSuite() {
         std::cout << "\n[CRITICAL FAILURE] Neocekavana vyjimka v main: " << e.what() << "\n";
     }
 }
+/*
+ * Průměrná doba jednoho volání fn v mikrosekundách.
+ * Opakuje měření, dokud neuběhne alespoň min_ms milisekund.
+ */
+double measureMicros(const std::function<void()>& fn, const double min_ms = 200.0) {
+    using clock = std::chrono::steady_clock;
+    size_t reps = 0;
+    const auto start = clock::now();
+    double elapsed_ms = 0.0;
+    do {
+        fn();
+        ++reps;
+        elapsed_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    } while (elapsed_ms < min_ms);
+    return elapsed_ms * 1000.0 / static_cast<double>(reps);
+}
+
+/*
+ * Původní tokenizer MPTerm (regex sestavený pro každý řádek), slouží jen jako
+ * srovnání v benchmarku. Unární mínus se tu neslučuje, na rychlost to vliv nemá.
+ */
+std::vector<std::string> regexTokenize(const std::string& line) {
+    std::vector<std::string> tokens;
+    std::regex re(R"((exit|bank|\$\d+|\d+|[-+*/%!^]))");
+    for (auto it = std::sregex_iterator(line.begin(), line.end(), re); it != std::sregex_iterator(); ++it) {
+        tokens.push_back(it->str());
+    }
+    return tokens;
+}
+
+void runBenchmark() {
+    std::mt19937_64 rng(42);
+    std::cout << std::fixed << std::setprecision(1);
+
+    // =============================================================
+    // NÁSOBENÍ: Karatsuba/Toom-3 vs NTT
+    // =============================================================
+    printHeader("Nasobeni: Karatsuba/Toom-3 vs NTT (cas v us)");
+    {
+        const mpn::MulThresholds saved = mpn::mul_thresholds;
+        size_t crossover = 0;
+
+        std::cout << std::setw(10) << "limby" << std::setw(16) << "Toom-3" << std::setw(16) << "NTT" << "\n";
+        for (size_t n = 500; n <= 64000; n *= 2) {
+            std::vector<mpn::limb_t> a(n), b(n), r(2 * n);
+            for (auto& x : a) x = rng();
+            for (auto& x : b) x = rng();
+
+            mpn::mul_thresholds.ntt = SIZE_MAX;
+            const double toom = measureMicros([&] { mpn::mul(r.data(), a.data(), n, b.data(), n); });
+            mpn::mul_thresholds.ntt = 0;
+            const double ntt = measureMicros([&] { mpn::mul(r.data(), a.data(), n, b.data(), n); });
+            mpn::mul_thresholds = saved;
+
+            if (ntt < toom && crossover == 0) crossover = n;
+            std::cout << std::setw(10) << n << std::setw(16) << toom << std::setw(16) << ntt << "\n";
+        }
+
+        std::cout << "NTT je rychlejsi od " << crossover << " limbu, nastaveny prah je "
+                  << mpn::mul_thresholds.ntt << " limbu.\n";
+    }
+
+    // =============================================================
+    // TOKENIZER: regex vs ruční lexer
+    // =============================================================
+    printHeader("Tokenizer: regex vs rucni lexer (radky za sekundu)");
+    {
+        std::vector<std::string> lines;
+        for (int i = 0; i < 1000; ++i) {
+            lines.push_back(std::to_string(rng() % 1000000) + " * -" + std::to_string(rng() % 1000000));
+            lines.push_back("$" + std::to_string(1 + rng() % 5) + " + " + std::to_string(rng()));
+            lines.push_back(std::to_string(rng() % 100) + " !");
+        }
+
+        size_t sink = 0;
+        const double regex_us = measureMicros([&] {
+            for (const auto& line : lines) sink += regexTokenize(line).size();
+        });
+        std::vector<std::string_view> tokens;
+        const double lexer_us = measureMicros([&] {
+            for (const auto& line : lines) {
+                MPTerm<0>::tokenize(line, tokens);
+                sink += tokens.size();
+            }
+        });
+
+        const double count = static_cast<double>(lines.size());
+        std::cout << std::setw(10) << "regex" << std::setw(16) << count / regex_us * 1e6 << "\n";
+        std::cout << std::setw(10) << "lexer" << std::setw(16) << count / lexer_us * 1e6 << "\n";
+        std::cout << "Zrychleni " << regex_us / lexer_us << "x (" << sink % 10 << ")\n";
+    }
+
+    // =============================================================
+    // ŘETĚZEC SČÍTÁNÍ: složené operátory vs líné výrazy
+    // =============================================================
+    printHeader("Retezec a + b + c - d: slozene operatory vs line vyrazy (cas v ns)");
+    {
+        std::cout << std::setw(10) << "limby" << std::setw(16) << "+= / -=" << std::setw(16) << "line" << "\n";
+        for (size_t n : {4, 64, 1024}) {
+            auto random = [&] {
+                std::string digits;
+                for (size_t i = 0; i < n * 19; ++i) digits.push_back(static_cast<char>('1' + rng() % 9));
+                return MPInt<0>(digits);
+            };
+            const MPInt<0> a = random(), b = random(), c = random(), d = random();
+            MPInt<0> r;
+
+            const double compound = measureMicros([&] {
+                MPInt<0> t = a;
+                t += b;
+                t += c;
+                t -= d;
+                r = std::move(t);
+            });
+            const double lazy = measureMicros([&] { r = a + b + c - d; });
+            std::cout << std::setw(10) << n << std::setw(16) << compound * 1000 << std::setw(16) << lazy * 1000 << "\n";
+        }
+    }
+
+    // =============================================================
+    // SČÍTÁNÍ NA MÍSTĚ: += a -= bez pomocných kopií
+    // =============================================================
+    printHeader("Scitani na miste: x += a; x -= a (cas v ns)");
+    {
+        auto randomDigits = [&](size_t digits) {
+            std::string s;
+            for (size_t i = 0; i < digits; ++i) s.push_back(static_cast<char>('1' + rng() % 9));
+            return s;
+        };
+        // kladné a záporné a - stejná znaménka sčítají, různá odčítají a mění znaménko x
+        auto measure = [&]<size_t P>(const std::string& name, size_t digits) {
+            MPInt<P> x(randomDigits(digits / 2));
+            const MPInt<P> a(randomDigits(digits)), neg_a(MPInt<P>(0) - a);
+            const double same = measureMicros([&] { x += a; x -= a; });
+            const double mixed = measureMicros([&] { x += neg_a; x -= neg_a; });
+            std::cout << std::setw(10) << name << std::setw(16) << same * 1000 << std::setw(16) << mixed * 1000 << "\n";
+        };
+        std::cout << std::setw(10) << "typ" << std::setw(16) << "a > 0" << std::setw(16) << "a < 0" << "\n";
+        measure.operator()<32>("MPInt<32>", 70);
+        measure.operator()<0>("MPInt<0>", 70);
+        measure.operator()<0>("64 limbu", 64 * 19);
+    }
+
+    // =============================================================
+    // VEKTOROVÁ JÁDRA: široká čísla s pevnou přesností
+    // =============================================================
+    printHeader(std::string("Vektorova jadra: skalarni vs ") + mpn::simd::levelName(mpn::simd::level()) +
+                " (cas v ns)");
+    {
+        const mpn::simd::Level best = mpn::simd::level();
+        auto randomDigits = [&](size_t digits) {
+            std::string s;
+            for (size_t i = 0; i < digits; ++i) s.push_back(static_cast<char>('1' + rng() % 9));
+            return s;
+        };
+        // plná čísla, porovnávaná se liší až v nejnižším limbu
+        auto measure = [&]<size_t P>(const std::string& name) {
+            const size_t digits = P * 8 * 3 / 10 - 2;
+            const MPInt<P> a(randomDigits(digits)), b(randomDigits(digits));
+            MPInt<P> almost = a;
+            almost += MPInt<P>(1);
+            MPInt<P> x = a;
+            std::cout << std::setw(12) << name;
+            for (const mpn::simd::Level level : {mpn::simd::Level::Scalar, best}) {
+                mpn::simd::setLevel(level);
+                const double add = measureMicros([&] { x += b; x -= b; }) / 2;
+                const double cmp = measureMicros([&] { (void)(a < almost); });
+                std::cout << std::setw(10) << add * 1000 << std::setw(10) << cmp * 1000;
+            }
+            std::cout << "\n";
+        };
+        std::cout << std::setw(12) << "typ" << std::setw(10) << "+= -=" << std::setw(10) << "<"
+                  << std::setw(10) << "+= -=" << std::setw(10) << "<" << "\n";
+        measure.operator()<256>("MPInt<256>");
+        measure.operator()<512>("MPInt<512>");
+        measure.operator()<1024>("MPInt<1024>");
+    }
+
+    // =============================================================
+    // DÁVKY: MPIntBatch
+    // =============================================================
+    printHeader("Davka MPInt<32>: po jednom vs MPIntBatch (cas v ns na cislo)");
+    {
+        constexpr size_t count = 100000;
+        std::vector<MPInt<32>> xs, ys, rs(count);
+        for (size_t i = 0; i < count; ++i) {
+            std::string s, t = rng() % 2 ? "-" : "";
+            for (int k = 0; k < 30; ++k) {
+                s.push_back(static_cast<char>('1' + rng() % 9));
+                t.push_back(static_cast<char>('1' + rng() % 9));
+            }
+            xs.emplace_back(s);
+            ys.emplace_back(t);
+        }
+        const MPIntBatch<32> a{std::span<const MPInt<32>>(xs)}, b{std::span<const MPInt<32>>(ys)};
+        MPIntBatch<32> r(count);
+        std::vector<std::uint8_t> overflow;
+        std::vector<std::int8_t> order(count);
+
+        // po jednom s ošetřením přetečení, jak by to psal volající bez dávek
+        auto single = [&](int op) {
+            for (size_t i = 0; i < count; ++i) {
+                rs[i] = xs[i];
+                try {
+                    if (op == 0) rs[i] += ys[i];
+                    else if (op == 1) rs[i] -= ys[i];
+                    else rs[i] *= ys[i];
+                } catch (const MPInt<32>::OverflowException& e) {
+                    rs[i] = e.getResult();
+                }
+            }
+        };
+        const double ns = 1000.0 / count;
+        std::cout << std::setw(10) << "operace" << std::setw(14) << "po jednom" << std::setw(14) << "davka" << "\n";
+        const char* names[] = {"+", "-", "*"};
+        for (int op = 0; op < 3; ++op) {
+            const double one = measureMicros([&] { single(op); });
+            const double batch = measureMicros([&] {
+                if (op == 0) r.add(a, b, overflow);
+                else if (op == 1) r.sub(a, b, overflow);
+                else r.mul(a, b, overflow);
+            });
+            std::cout << std::setw(10) << names[op] << std::setw(14) << one * ns << std::setw(14) << batch * ns << "\n";
+        }
+        const double one = measureMicros([&] {
+            for (size_t i = 0; i < count; ++i) order[i] = xs[i] < ys[i] ? -1 : xs[i] == ys[i] ? 0 : 1;
+        });
+        const double batch = measureMicros([&] { MPIntBatch<32>::compare(a, b, order); });
+        std::cout << std::setw(10) << "<=>" << std::setw(14) << one * ns << std::setw(14) << batch * ns << "\n";
+    }
+
+    // =============================================================
+    // PŘETEČENÍ: výjimka vs příznak
+    // =============================================================
+    printHeader("Preteceni MPInt<16>: vyjimka vs Overflow::Wrap (cas v ns)");
+    {
+        // každé druhé sčítání a násobení přeteče
+        const MPInt<16> big("300000000000000000000000000000000000000");
+        const MPInt<16> small(12345);
+        MPInt<16> x;
+        size_t overflows = 0;
+        auto throwing = [&](const MPInt<16>& b, bool multiply) {
+            x = big;
+            try {
+                if (multiply) x *= b;
+                else x += b;
+            } catch (const MPInt<16>::OverflowException& e) {
+                x = e.getResult();
+                ++overflows;
+            }
+        };
+        auto wrapping = [&](const MPInt<16>& b, bool multiply) {
+            x = big;
+            overflows += multiply ? x.mul<Overflow::Wrap>(b) : x.add<Overflow::Wrap>(b);
+        };
+        std::cout << std::setw(16) << "operace" << std::setw(12) << "vyjimka" << std::setw(12) << "Wrap" << "\n";
+        for (const bool multiply : {false, true}) {
+            const double t = measureMicros([&] { throwing(small, multiply); throwing(big, multiply); }) / 2;
+            const double w = measureMicros([&] { wrapping(small, multiply); wrapping(big, multiply); }) / 2;
+            std::cout << std::setw(16) << (multiply ? "* (50 % pret.)" : "+ (50 % pret.)")
+                      << std::setw(12) << t * 1000 << std::setw(12) << w * 1000 << "\n";
+        }
+        if (overflows == 0) std::cout << "(zadne preteceni)\n";
+    }
+
+    // =============================================================
+    // KONSTANTY: parsování za běhu vs literál _mp
+    // =============================================================
+    printHeader("Konstanta MPInt<32>: retezec za behu vs literal _mp (cas v ns)");
+    {
+        MPInt<32> x;
+        const double parsed = measureMicros([&] { x = MPInt<32>("123456789012345678901234567890"); });
+        const double literal = measureMicros([&] { x = 123'456'789'012'345'678'901'234'567'890_mp; });
+        std::cout << std::setw(16) << "retezec" << std::setw(12) << parsed * 1000 << "\n";
+        std::cout << std::setw(16) << "_mp" << std::setw(12) << literal * 1000 << "\n";
+    }
+
+    // =============================================================
+    // SERIALIZACE: desítkový řetězec vs šestnáctkový vs binární formát
+    // =============================================================
+    printHeader("Zapis a cteni MPInt<0>: desitkove vs hex vs binarne (cas v us)");
+    {
+        std::cout << std::setw(10) << "limbu" << std::setw(12) << "desitkove" << std::setw(10) << "hex"
+                  << std::setw(12) << "binarne" << std::setw(10) << "view" << "\n";
+        for (const uint64_t n : {100, 1000, 5000}) {
+            const MPInt<0> x = MPInt<0>(n).factorial();
+            std::string text;
+            std::vector<std::byte> bytes(x.serializedSize());
+            MPInt<0> y;
+            const double decimal = measureMicros([&] { x.toString(text); y = MPInt<0>(text); });
+            const double hex = measureMicros([&] { x.toHex(text); y = MPInt<0>::fromHex(text); });
+            const double binary = measureMicros([&] { x.serialize(bytes); y = MPInt<0>::deserialize(bytes); });
+            size_t total = 0;
+            const double view = measureMicros([&] { x.serialize(bytes); total += MPIntView::deserialize(bytes).limbs().size(); });
+            std::cout << std::setw(10) << (x.serializedSize() / 8 - 1) << std::setw(12) << decimal << std::setw(10) << hex
+                      << std::setw(12) << binary << std::setw(10) << view << "\n";
+            if (total == 0) std::cout << "(prazdne view)\n";
+        }
+    }
+
+    // =============================================================
+    // BANKA HISTORIE: soubor mapovaný do paměti
+    // =============================================================
+    printHeader("Banka historie: append a $N nad milionem vysledku (cas v ns)");
+    {
+        const std::string path = (std::filesystem::temp_directory_path() / "sem_2_bench.bank").string();
+        std::filesystem::remove(path);
+        std::filesystem::remove(path + ".idx");
+        {
+            HistoryBank bank(path);
+            const size_t count = 1000000;
+            MPInt<0> value("123456789012345678901234567890");
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; ++i) {
+                value += 1;
+                bank.append(value);
+            }
+            const double append = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+
+            // $N na náhodné pozici do zahřátého registru (jako MPExpr)
+            MPInt<0> reg;
+            size_t i = 0;
+            const double recall = measureMicros([&] { reg = bank.recent((i++ * 7919) % count); });
+
+            // velký výsledek: limby se kopírují ze souboru do registru, který už má kapacitu
+            bank.append(MPInt<0>(3).pow(200000));
+            reg = bank.recent(0);
+            const size_t before = heap_allocations.load();
+            const double big = measureMicros([&] { reg = bank.recent(0); });
+            const size_t allocations = heap_allocations.load() - before;
+
+            std::cout << std::setw(34) << "append (30 cifer)" << std::setw(12) << append << "\n";
+            std::cout << std::setw(34) << "$N nahodne z 10^6" << std::setw(12) << recall * 1000 << "\n";
+            std::cout << std::setw(34) << "$1 = 3^200000 (" + std::to_string(reg.serializedSize() / 8 - 1) + " limbu)"
+                      << std::setw(12) << big * 1000 << "  alokaci: " << allocations << "\n";
+        }
+        std::filesystem::remove(path);
+        std::filesystem::remove(path + ".idx");
+    }
+
+    // =============================================================
+    // ALOKACE NA HALDĚ: Unlimited s vnitřním bufferem
+    // =============================================================
+    printHeader("Alokace na halde: MPInt<0> a MPTerm<0> (pocet alokaci)");
+    {
+        // aritmetika s hodnotami do 256 bitů se vejde do vnitřního bufferu LimbVector
+        const MPInt<0> a("123456789012345678901234567890"), b(-987654321);
+        MPInt<0> x;
+        std::string text;
+        text.reserve(128);
+        size_t before = heap_allocations.load();
+        for (int i = 0; i < 1000; ++i) {
+            x = a + b;
+            x = a * b;
+            x = a / b;
+            x = a % b;
+            x -= a;
+            x *= 7;
+            x = b.pow(3);
+            x.toString(text);
+        }
+        const size_t arithmetic = heap_allocations.load() - before;
+
+        // typické řádky kalkulačky v dávkovém režimu, výstup se zahodí
+        struct NullBuffer : std::streambuf {
+            int overflow(int c) override { return c; }
+            std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+        } null_buffer;
+        std::string input;
+        const int lines = 20000;
+        for (int i = 0; i < lines / 5; ++i) {
+            input += std::to_string(rng() % 1000000) + " * " + std::to_string(rng() % 1000000) + "\n";
+            input += "$1 + 42\n";
+            input += "(5 + 7) * 3 - $2\n";
+            input += "2 ^ 64 % 1000007\n";
+            input += "20 ! / $3\n";
+        }
+        std::istringstream in(input);
+        std::streambuf* saved = std::cout.rdbuf(&null_buffer);
+        before = heap_allocations.load();
+        {
+            MPTerm<0> term;
+            term.runBatch(in);
+        }
+        const size_t repl = heap_allocations.load() - before;
+        std::cout.rdbuf(saved);
+
+        std::cout << std::setw(28) << "8000 operaci MPInt<0>" << std::setw(10) << arithmetic << "\n";
+        std::cout << std::setw(28) << std::to_string(lines) + " radku MPTerm<0>" << std::setw(10) << repl
+                  << "  (buffery vstupu, vystupu a historie, nezavisi na poctu radku)\n";
+    }
+
+    // =============================================================
+    // ODKLÁDACÍ ARÉNA: alokace velkých výpočtů
+    // =============================================================
+    printHeader("Odkladaci arena: alokace factorial() a toString() (pocet alokaci)");
+    {
+        std::cout << std::setw(10) << "n" << std::setw(14) << "factorial" << std::setw(14) << "toString"
+                  << std::setw(14) << "parse" << "\n";
+        std::string text;
+        for (long long n = 1000; n <= 100000; n *= 10) {
+            const MPInt<0> x(n);
+            // první výpočet zahřeje arénu, měří se opakované volání
+            MPInt<0> f = x.factorial(1);
+            f.toString(text);
+            size_t before = heap_allocations.load();
+            f = x.factorial(1);
+            const size_t fact = heap_allocations.load() - before;
+            before = heap_allocations.load();
+            f.toString(text);
+            const size_t print = heap_allocations.load() - before;
+            before = heap_allocations.load();
+            const MPInt<0> parsed(text);
+            const size_t parse = heap_allocations.load() - before;
+            std::cout << std::setw(10) << n << std::setw(14) << fact << std::setw(14) << print
+                      << std::setw(14) << parse << "\n";
+        }
+        std::cout << "  (factorial: lichy soucin, posunuty vysledek a data MPInt; parse: jen vysledne cislo)\n";
+    }
+
+    // =============================================================
+    // MALÁ ČÍSLA VE VELKÉ PŘESNOSTI
+    // =============================================================
+    printHeader("Mala cisla: MPInt<32> vs MPInt<4096> (cas v ns)");
+    {
+        auto measure = [&]<size_t P>(const std::string& name) {
+            const MPInt<P> a(123456789), b(-987654321);
+            MPInt<P> x;
+            const double mul = measureMicros([&] { x = a; x *= b; });
+            const double add = measureMicros([&] { x = a; x += b; });
+            const double div = measureMicros([&] { x = b; x /= a; });
+            const double cmp = measureMicros([&] { x = a; (void)(x < b); });
+            std::cout << std::setw(12) << name << std::setw(10) << mul * 1000 << std::setw(10) << add * 1000
+                      << std::setw(10) << div * 1000 << std::setw(10) << cmp * 1000 << "\n";
+        };
+        std::cout << std::setw(12) << "typ" << std::setw(10) << "*=" << std::setw(10) << "+="
+                  << std::setw(10) << "/=" << std::setw(10) << "<" << "\n";
+        measure.operator()<32>("MPInt<32>");
+        measure.operator()<4096>("MPInt<4096>");
+    }
+
+    // =============================================================
+    // FAKTORIÁL: počet vláken
+    // =============================================================
+    printHeader("Faktorial: strom soucinu podle poctu vlaken (cas v us)");
+    {
+        const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        std::cout << std::setw(10) << "n" << std::setw(16) << "1 vlakno" << std::setw(16) << hw << " vlaken\n";
+        for (unsigned long long n = 10000; n <= 1000000; n *= 10) {
+            const MPInt<0> x(static_cast<long long>(n));
+            const double single = measureMicros([&] { (void)x.factorial(1); });
+            const double parallel = measureMicros([&] { (void)x.factorial(hw); });
+            std::cout << std::setw(10) << n << std::setw(16) << single << std::setw(16) << parallel << "\n";
+        }
+    }
+}
+
 int main(const int argc, const char **argv) {
-    if (argc != 2) {
-        std::cout << "pouziti: my_program.exe <mode>\n";
+    if (argc != 2 && argc != 3) {
+        std::cout << "pouziti: my_program.exe <mode> [banka]\n";
         printModeHelp();
         return 1;
     }
 
     int mode;
     auto result = std::from_chars(argv[1], argv[1] + std::strlen(argv[1]), mode);
-    if (result.ec != std::errc() || mode < 1 || mode > 3) {
-        std::cerr << "mode musi byt 1, 2 nebo 3.\n";
+    if (result.ec != std::errc() || mode < 1 || mode > 5) {
+        std::cerr << "mode musi byt 1, 2, 3, 4 nebo 5.\n";
         printModeHelp();
         return 1;
     }
 
-    if (mode == 1) {
-        std::cout << "MPCalc - rezim s neomezenou presnosti" << std::endl
-        << "Zadejte jednoduchy matematicky vyraz s nejvyse jednou operaci +, -, *, / nebo !" << std::endl;
-        MPTerm<0> term;
-        term.run();
-    }
-    else if (mode == 2) {
-        std::cout << "MPCalc - rezim s omezenou přesností na 32 bytů" << std::endl
-        << "Zadejte jednoduchy matematicky vyraz s nejvyse jednou operaci +, -, *, / nebo !" << std::endl;
-        MPTerm<32> term;
-        term.run();
-    }
-    else {
-        runTestSuite();
+    const std::string bank_path = argc == 3 ? argv[2] : "";
+    try {
+        if (mode == 1) {
+            runTerm<0>("MPCalc - rezim s neomezenou presnosti", bank_path);
+        }
+        else if (mode == 2) {
+            runTerm<32>("MPCalc - rezim s omezenou přesností na 32 bytů", bank_path);
+        }
+        else if (mode == 3) {
+            runTestSuite();
+        }
+        else if (mode == 4) {
+            runBenchmark();
+        }
+        else {
+            std::ios::sync_with_stdio(false);
+            MPTerm<0> term;
+            if (!bank_path.empty()) term.openBank(bank_path);
+            term.runParallelBatch();
+        }
+    } catch (const std::exception& e) {
+        // hlavně banka, kterou nejde otevřít
+        std::cerr << "Chyba: " << e.what() << "\n";
+        return 1;
     }
 
     return 0;
@@ -0,0 +1,169 @@
+#ifndef SEM_2_MPARENA_H
+#define SEM_2_MPARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include "mpn.h"
+
+/*
+ * Odkládací paměť (scratch arena) pro mezivýsledky výpočetních jader.
+ * - Každé vlákno má vlastní arénu, alokace tedy nepotřebuje zámky a je jen posunem ukazatele.
+ * - Buffery se uvolňují v opačném pořadí, než vznikly (LIFO), což přesně odpovídá
+ *   lokálním proměnným rekurzivních algoritmů (Karatsuba, Toom-3, Newton, převody).
+ * - Paměť se po výpočtu systému nevrací: jakmile aréna jednou vyroste na velikost úlohy,
+ *   další stejně velké výpočty už na haldě nealokují vůbec.
+ * - Pokud se požadavek nevejde, přidá se blok s alespoň dvojnásobnou kapacitou.
+ *   Bloky po skončení výpočtu zůstávají jako zásoba pro další volání.
+ */
+namespace mpn {
+
+class ScratchArena {
+public:
+    // nejmenší blok (32 KiB), aby malé výpočty vystačily s jednou alokací
+    static constexpr std::size_t MIN_BLOCK = 4096;
+
+    ScratchArena() = default;
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // aréna volajícího vlákna
+    static ScratchArena& local() noexcept {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+
+    // n limbů s nedefinovaným obsahem; při std::bad_alloc zůstanou existující buffery platné
+    limb_t* allocate(std::size_t n) {
+        n = std::max<std::size_t>(n, 1);
+        if (!blocks.empty()) {
+            if (blocks[top].size - blocks[top].used >= n) return bump(blocks[top], n);
+            // bloky nad top jsou prázdné zásoby z dřívějška
+            if (top + 1 < blocks.size() && blocks[top + 1].size >= n) return bump(blocks[++top], n);
+        }
+        return grow(std::max({n, 2 * capacity(), MIN_BLOCK}), n);
+    }
+
+    // uvolní posledně alokovaný buffer (p, n musí odpovídat volání allocate)
+    void release([[maybe_unused]] limb_t* p, std::size_t n) noexcept {
+        blocks[top].used -= std::max<std::size_t>(n, 1);
+        while (top > 0 && blocks[top].used == 0) --top;
+    }
+
+    // počet limbů ve všech blocích
+    std::size_t capacity() const noexcept {
+        std::size_t total = 0;
+        for (const Block& block : blocks) total += block.size;
+        return total;
+    }
+
+    // počet limbů právě používaných buffery
+    std::size_t inUse() const noexcept {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < blocks.size() && i <= top; ++i) total += blocks[i].used;
+        return total;
+    }
+
+    // vrátí paměť systému, pokud se zrovna nic nepoužívá
+    void shrink() noexcept {
+        if (inUse() == 0) {
+            blocks.clear();
+            top = 0;
+        }
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<limb_t[]> data;
+        std::size_t size;
+        std::size_t used;
+    };
+
+    std::vector<Block> blocks;   // blocks[0..top] se používají, vyšší jsou prázdné
+    std::size_t top = 0;
+
+    static limb_t* bump(Block& block, std::size_t n) noexcept {
+        limb_t* p = block.data.get() + block.used;
+        block.used += n;
+        return p;
+    }
+
+    // nový blok velikosti size nad top (menší zásoby nad ním se zahodí), z něj n limbů
+    limb_t* grow(std::size_t size, std::size_t n) {
+        if (blocks.size() == blocks.capacity()) blocks.reserve(std::max<std::size_t>(8, 2 * blocks.size()));
+        std::unique_ptr<limb_t[]> data(new limb_t[size]);
+        if (!blocks.empty()) {
+            blocks.erase(blocks.begin() + static_cast<std::ptrdiff_t>(top) + 1, blocks.end());
+            if (blocks[top].used != 0) ++top;
+            else blocks.pop_back();   // prázdné dno (top == 0), nahradí ho větší blok
+        }
+        blocks.push_back(Block{std::move(data), size, 0});
+        return bump(blocks[top], n);
+    }
+};
+
+/*
+ * Dočasný buffer n limbů v aréně aktuálního vlákna, uvolní se na konci rozsahu.
+ * Obsah je nedefinovaný, pokud se nezadá počáteční hodnota.
+ */
+class ScratchBuffer {
+public:
+    explicit ScratchBuffer(std::size_t n)
+        : arena(ScratchArena::local()), ptr(arena.allocate(n)), len(n) {}
+
+    ScratchBuffer(std::size_t n, limb_t value) : ScratchBuffer(n) {
+        std::fill_n(ptr, n, value);
+    }
+
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    ~ScratchBuffer() {
+        arena.release(ptr, len);
+    }
+
+    std::size_t size() const noexcept { return len; }
+    limb_t* data() noexcept { return ptr; }
+    const limb_t* data() const noexcept { return ptr; }
+    limb_t* begin() noexcept { return ptr; }
+    const limb_t* begin() const noexcept { return ptr; }
+    limb_t* end() noexcept { return ptr + len; }
+    const limb_t* end() const noexcept { return ptr + len; }
+    limb_t& operator[](std::size_t i) noexcept { return ptr[i]; }
+    const limb_t& operator[](std::size_t i) const noexcept { return ptr[i]; }
+
+private:
+    ScratchArena& arena;
+    limb_t* ptr;
+    std::size_t len;
+};
+
+namespace detail {
+
+template<typename Fn>
+auto withArena(std::size_t n, Fn& fn) {
+    ScratchBuffer buffer(n);
+    return fn(buffer.data());
+}
+
+} // namespace detail
+
+/*
+ * Zavolá fn(limb_t*) s dočasným bufferem n limbů a vrátí jeho výsledek.
+ * Za běhu je buffer v aréně, při vyhodnocení v době překladu (constexpr) ve std::vector,
+ * protože thread_local arénu tam použít nejde. Obsah je nedefinovaný.
+ */
+template<typename Fn>
+constexpr auto withScratch(std::size_t n, Fn&& fn) {
+    if (std::is_constant_evaluated()) {
+        std::vector<limb_t> buffer(n);
+        return fn(buffer.data());
+    }
+    return detail::withArena(n, fn);
+}
+
+} // namespace mpn
+
+#endif
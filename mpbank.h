@@ -0,0 +1,251 @@
+#ifndef SEM_2_MPBANK_H
+#define SEM_2_MPBANK_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <algorithm>
+#include "mpint.h"
+#include "mpwire.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SEM_2_MPBANK_MMAP 1
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*
+ * Trvalá historie výsledků v souborech mapovaných do paměti (banka pro MPTerm).
+ * - Soubor path drží výsledky za sebou v binárním formátu MPInt (mpwire.h) a jen se
+ *   k němu připisuje. Soubor path.idx drží počet výsledků a offset každého z nich,
+ *   takže $N je jedno čtení z indexu bez ohledu na velikost banky.
+ * - Oba soubory jsou namapované (MAP_SHARED) do předem rezervovaného rozsahu adres,
+ *   růst souboru mapování nestěhuje. MPIntView vrácené bankou čte limby přímo ze stránek
+ *   souboru (nic se nekopíruje na haldu) a platí, dokud banka žije, i po dalších append.
+ * - Počet výsledků se v indexu zvýší až po zápisu dat, takže přerušený append nechá banku
+ *   v posledním úplném stavu. Při zavření se soubory zkrátí na skutečnou délku.
+ * - Limby se čtou v nativním pořadí bajtů, banka tedy předpokládá Little Endian procesor
+ *   (stejně jako MPIntView). Bez mmap (Windows) konstruktor vyhodí std::runtime_error.
+ */
+class HistoryBank {
+public:
+    // otevře existující banku, nebo vytvoří novou; chyba souboru nebo poškozená data vyhodí std::runtime_error
+    explicit HistoryBank(const std::string& path) {
+#ifdef SEM_2_MPBANK_MMAP
+        try {
+            const size_t data_size = open(data_file, path, DATA_RESERVE);
+            const size_t index_size = open(index_file, path + ".idx", INDEX_RESERVE);
+            if (data_size == 0 && index_size == 0) {
+                grow(data_file, mpn::wire::HEADER_BYTES);
+                grow(index_file, INDEX_HEADER_WORDS * sizeof(std::uint64_t));
+                dataWord(0) = DATA_MAGIC;
+                indexWords()[0] = INDEX_MAGIC;
+                indexWords()[1] = 0;
+                data_end = mpn::wire::HEADER_BYTES;
+            }
+            else {
+                validate(path, data_size, index_size);
+            }
+            opened = true;
+        } catch (...) {
+            close();
+            throw;
+        }
+#else
+        throw std::runtime_error("History bank needs mmap, which is not available: " + path);
+#endif
+    }
+
+    ~HistoryBank() {
+        close();
+    }
+
+    HistoryBank(const HistoryBank&) = delete;
+    HistoryBank& operator=(const HistoryBank&) = delete;
+
+    // počet uložených výsledků
+    size_t size() const {
+        return index_file.base ? static_cast<size_t>(indexWords()[1]) : 0;
+    }
+
+    // i-tý uložený výsledek (0 = nejstarší), limby zůstávají v souboru
+    MPIntView operator[](size_t i) const {
+        if (i >= size()) {
+            throw std::out_of_range("History bank index out of range");
+        }
+        // validate kontroluje jen poslední záznam, offset ze středu indexu se ověří až tady
+        const size_t offset = static_cast<size_t>(indexWords()[INDEX_HEADER_WORDS + i]);
+        if (offset < mpn::wire::HEADER_BYTES || offset >= data_end || offset % sizeof(std::uint64_t) != 0) {
+            throw std::runtime_error("History bank index is corrupted");
+        }
+        return MPIntView::deserialize(std::span<const std::byte>(data_file.base + offset, data_end - offset));
+    }
+
+    // výsledek $(n + 1) terminálu: recent(0) je nejnovější
+    MPIntView recent(size_t n) const {
+        if (n >= size()) {
+            throw std::out_of_range("History bank index out of range");
+        }
+        return (*this)[size() - 1 - n];
+    }
+
+    // připíše výsledek na konec banky
+    template<size_t P>
+    void append(const MPInt<P>& value) {
+        const size_t bytes = value.serializedSize();
+        const size_t count = size();
+        grow(data_file, data_end + bytes);
+        grow(index_file, (INDEX_HEADER_WORDS + count + 1) * sizeof(std::uint64_t));
+
+        const std::span<std::byte> record(data_file.base + data_end, bytes);
+        value.serialize(record);
+        // do banky jen záznam, který jde přečíst zpět (jinak by při dalším otevření byla celá poškozená)
+        try {
+            mpn::wire::decodeHeader(record);
+        } catch (const std::invalid_argument& e) {
+            throw std::runtime_error(std::string("History bank refused an unreadable record: ") + e.what());
+        }
+        indexWords()[INDEX_HEADER_WORDS + count] = data_end;
+        data_end += bytes;
+        // až teď je výsledek součástí banky
+        indexWords()[1] = count + 1;
+    }
+
+    // vynutí zápis na disk (jinak ho systém udělá sám, nejpozději při zavření)
+    void sync() const {
+#ifdef SEM_2_MPBANK_MMAP
+        if (data_file.base) ::msync(data_file.base, data_file.mapped, MS_SYNC);
+        if (index_file.base) ::msync(index_file.base, index_file.mapped, MS_SYNC);
+#endif
+    }
+
+private:
+    // jeden soubor namapovaný na začátek rezervovaného rozsahu adres
+    struct Mapping {
+        int fd = -1;
+        std::byte* base = nullptr;
+        size_t reserved = 0;   // velikost rezervovaného rozsahu
+        size_t mapped = 0;     // velikost souboru = namapovaná část
+    };
+
+    // rezervace adres (ne paměti): 64 GiB dat a index pro 2^30 výsledků
+    static constexpr size_t DATA_RESERVE = size_t{1} << 36;
+    static constexpr size_t INDEX_RESERVE = size_t{1} << 33;
+    // nejmenší krok růstu souboru, pak se velikost zdvojnásobuje
+    static constexpr size_t MIN_GROWTH = size_t{1} << 20;
+
+    // index: [magic, počet výsledků, offset 0, offset 1, ...], data: [magic, záznamy...]
+    static constexpr size_t INDEX_HEADER_WORDS = 2;
+    static constexpr std::uint64_t DATA_MAGIC = 0x3154414442504d53;    // "SMPBDAT1"
+    static constexpr std::uint64_t INDEX_MAGIC = 0x3158444942504d53;   // "SMPBIDX1"
+
+    Mapping data_file;
+    Mapping index_file;
+    size_t data_end = 0;   // konec posledního záznamu v datech
+    bool opened = false;   // soubory prošly kontrolou, při zavření je lze zkrátit
+
+    std::uint64_t* indexWords() const {
+        return reinterpret_cast<std::uint64_t*>(index_file.base);
+    }
+
+    std::uint64_t& dataWord(size_t offset) const {
+        return *reinterpret_cast<std::uint64_t*>(data_file.base + offset);
+    }
+
+#ifdef SEM_2_MPBANK_MMAP
+    [[noreturn]] static void fail(const std::string& what) {
+        throw std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    // otevře soubor, zarezervuje adresy a namapuje jeho dosavadní obsah, vrací velikost souboru
+    static size_t open(Mapping& m, const std::string& path, size_t reserve) {
+        m.fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (m.fd < 0) fail("Cannot open history bank " + path);
+        struct stat st{};
+        if (::fstat(m.fd, &st) != 0) fail("Cannot stat history bank " + path);
+
+        void* p = ::mmap(nullptr, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED) fail("Cannot reserve address space for history bank " + path);
+        m.base = static_cast<std::byte*>(p);
+        m.reserved = reserve;
+
+        const size_t size = static_cast<size_t>(st.st_size);
+        if (size > reserve) throw std::runtime_error("History bank is too large: " + path);
+        if (size > 0) mapFile(m, size);
+        return size;
+    }
+
+    // namapuje prvních size bajtů souboru na m.base (na stejné adrese, původní stránky zůstanou)
+    static void mapFile(Mapping& m, size_t size) {
+        if (::mmap(m.base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, m.fd, 0) == MAP_FAILED) {
+            fail("Cannot map history bank");
+        }
+        m.mapped = size;
+    }
+#endif
+
+    // zajistí, že soubor má aspoň needed bajtů (roste po MIN_GROWTH, pak geometricky)
+    static void grow(Mapping& m, size_t needed) {
+        if (needed <= m.mapped) return;
+#ifdef SEM_2_MPBANK_MMAP
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t size = std::max({needed, 2 * m.mapped, MIN_GROWTH});
+        size = (size + page - 1) / page * page;
+        if (size > m.reserved) throw std::length_error("History bank is full");
+        if (::ftruncate(m.fd, static_cast<off_t>(size)) != 0) fail("Cannot grow history bank");
+        mapFile(m, size);
+#endif
+    }
+
+    // kontrola existující banky a nalezení konce dat
+    void validate(const std::string& path, size_t data_size, size_t index_size) {
+        const auto corrupted = [&] { return std::runtime_error("History bank is corrupted: " + path); };
+        if (data_size < mpn::wire::HEADER_BYTES || index_size < INDEX_HEADER_WORDS * sizeof(std::uint64_t)
+            || dataWord(0) != DATA_MAGIC || indexWords()[0] != INDEX_MAGIC) {
+            throw corrupted();
+        }
+        const size_t count = static_cast<size_t>(indexWords()[1]);
+        if (count > index_size / sizeof(std::uint64_t) - INDEX_HEADER_WORDS) throw corrupted();
+
+        data_end = mpn::wire::HEADER_BYTES;
+        if (count > 0) {
+            const size_t last = static_cast<size_t>(indexWords()[INDEX_HEADER_WORDS + count - 1]);
+            if (last < mpn::wire::HEADER_BYTES || last >= data_size || last % sizeof(std::uint64_t) != 0) throw corrupted();
+            try {
+                const mpn::wire::Header header = mpn::wire::decodeHeader(
+                    std::span<const std::byte>(data_file.base + last, data_size - last));
+                data_end = last + mpn::wire::encodedSize(header.len);
+            } catch (const std::invalid_argument&) {
+                throw corrupted();
+            }
+        }
+    }
+
+    // zkrácení souborů na skutečnou délku, uvolnění mapování
+    void close() noexcept {
+#ifdef SEM_2_MPBANK_MMAP
+        // poškozenou nebo cizí banku nechat, jak je
+        const size_t index_end = opened ? (INDEX_HEADER_WORDS + size()) * sizeof(std::uint64_t) : 0;
+        for (Mapping* m : {&data_file, &index_file}) {
+            if (m->base) ::munmap(m->base, m->reserved);
+            if (m->fd >= 0) {
+                if (opened) {
+                    const size_t end = m == &data_file ? data_end : index_end;
+                    [[maybe_unused]] const int ignored = ::ftruncate(m->fd, static_cast<off_t>(end));
+                }
+                ::close(m->fd);
+            }
+            *m = Mapping{};
+        }
+        opened = false;
+#endif
+    }
+};
+
+#endif
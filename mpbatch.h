@@ -0,0 +1,360 @@
+#ifndef SEM_2_MPBATCH_H
+#define SEM_2_MPBATCH_H
+
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <stdexcept>
+#include "mpn.h"
+#include "mpsimd.h"
+#include "mpint.h"
+
+/*
+ * Dávkové operace nad mnoha čísly stejné omezené přesnosti.
+ * - Čísla jsou uložená po sloupcích (structure of arrays): limb j všech čísel leží za sebou,
+ *   takže operace po prvcích zpracuje celý řádek limbů najednou a mezi čísly nejsou závislosti.
+ * - Sčítání, odčítání a porovnání běží bez větvení po blocích 8 čísel. Bloky mají pevnou
+ *   délku, takže je překladač vektorizuje, a jádra jsou přeložená i pro AVX2 a AVX-512
+ *   (úroveň vybírá mpsimd.h). Násobení počítá každé číslo zvlášť (64 x 64 -> 128 bitů
+ *   vektorově nejde), ušetří ale výjimky, kopie a zbytečné limby nad přesností.
+ * - Přetečení se nehlásí výjimkou: výsledek je oříznutý stejně jako v OverflowException
+ *   a v poli overflow má přetečené číslo jedničku.
+ */
+namespace mpn::batch {
+
+// počet čísel v jednom bloku jádra, délka řádku se zarovnává na jeho násobek
+constexpr std::size_t BLOCK = 8;
+
+struct AddArgs {
+    limb_t* r;
+    const limb_t* a;
+    const limb_t* b;
+    std::uint8_t* r_sign;
+    const std::uint8_t* a_sign;
+    const std::uint8_t* b_sign;
+    std::uint8_t* overflow;
+    std::size_t stride;     // délka řádku (počet čísel včetně zarovnání)
+    std::size_t limbs;
+    limb_t top_mask;
+    bool negate_b;          // r = a - b
+};
+
+struct CompareArgs {
+    const limb_t* a;
+    const limb_t* b;
+    const std::uint8_t* a_sign;
+    const std::uint8_t* b_sign;
+    std::int8_t* result;
+    std::size_t stride;
+    std::size_t limbs;
+};
+
+/*
+ * Blok čísel od base: r = a + (-1)^negate_b * b.
+ * Čísla s různým znaménkem sčítají a + ~b + 1 (tj. a - b ve dvojkovém doplňku). Chybějící
+ * přenos nahoře znamená |a| < |b|, takový výsledek se druhým průchodem zneguje.
+ */
+[[gnu::always_inline]] inline void addBlock(const AddArgs& x, std::size_t base) {
+    limb_t flip[BLOCK], carry[BLOCK], negate[BLOCK], nonzero[BLOCK];
+    for (std::size_t k = 0; k < BLOCK; ++k) {
+        const limb_t differ = (x.a_sign[base + k] ^ x.b_sign[base + k] ^ x.negate_b) & 1;
+        flip[k] = limb_t{0} - differ;
+        carry[k] = differ;
+    }
+
+    for (std::size_t j = 0; j < x.limbs; ++j) {
+        const limb_t* ar = x.a + j * x.stride + base;
+        const limb_t* br = x.b + j * x.stride + base;
+        limb_t* rr = x.r + j * x.stride + base;
+        for (std::size_t k = 0; k < BLOCK; ++k) {
+            const limb_t s = ar[k] + (br[k] ^ flip[k]);
+            const limb_t c1 = s < ar[k];
+            const limb_t t = s + carry[k];
+            carry[k] = c1 | (t < s);
+            rr[k] = t;
+        }
+    }
+
+    limb_t any = 0;
+    for (std::size_t k = 0; k < BLOCK; ++k) {
+        negate[k] = flip[k] & (carry[k] - 1);
+        any |= negate[k];
+        nonzero[k] = 0;
+    }
+    if (any != 0) {
+        // |a| < |b|: výsledek je -(|b| - |a|), z dvojkového doplňku zpět na velikost
+        limb_t inc[BLOCK];
+        for (std::size_t k = 0; k < BLOCK; ++k) inc[k] = negate[k] & 1;
+        for (std::size_t j = 0; j < x.limbs; ++j) {
+            limb_t* rr = x.r + j * x.stride + base;
+            for (std::size_t k = 0; k < BLOCK; ++k) {
+                const limb_t v = (rr[k] ^ negate[k]) + inc[k];
+                inc[k] = v < inc[k];
+                rr[k] = v;
+            }
+        }
+    }
+
+    // přetéct může jen součet stejných znamének: přenos nad pole nebo bity nad TOP_MASK
+    limb_t* top = x.r + (x.limbs - 1) * x.stride + base;
+    for (std::size_t k = 0; k < BLOCK; ++k) {
+        x.overflow[base + k] = static_cast<std::uint8_t>((~flip[k] & carry[k]) | (top[k] > x.top_mask));
+        top[k] &= x.top_mask;
+    }
+    for (std::size_t j = 0; j < x.limbs; ++j) {
+        const limb_t* rr = x.r + j * x.stride + base;
+        for (std::size_t k = 0; k < BLOCK; ++k) nonzero[k] |= rr[k];
+    }
+    for (std::size_t k = 0; k < BLOCK; ++k) {
+        x.r_sign[base + k] = static_cast<std::uint8_t>((x.a_sign[base + k] ^ (negate[k] & 1)) & (nonzero[k] != 0));
+    }
+}
+
+// blok čísel od base: result = -1, 0, 1 podle a <=> b (se znaménky)
+[[gnu::always_inline]] inline void compareBlock(const CompareArgs& x, std::size_t base) {
+    limb_t greater[BLOCK] = {}, less[BLOCK] = {};
+    for (std::size_t j = x.limbs; j > 0; --j) {
+        const limb_t* ar = x.a + (j - 1) * x.stride + base;
+        const limb_t* br = x.b + (j - 1) * x.stride + base;
+        for (std::size_t k = 0; k < BLOCK; ++k) {
+            // rozhoduje nejvyšší rozdílný limb
+            const limb_t open = (greater[k] | less[k]) ^ 1;
+            greater[k] |= open & (ar[k] > br[k]);
+            less[k] |= open & (ar[k] < br[k]);
+        }
+    }
+    for (std::size_t k = 0; k < BLOCK; ++k) {
+        const int sa = x.a_sign[base + k], sb = x.b_sign[base + k];
+        const int magnitude = static_cast<int>(greater[k]) - static_cast<int>(less[k]);
+        // různá znaménka: kladné (i nula) je větší; obě záporná: opačné pořadí velikostí
+        const int value = sa != sb ? sb - sa : (sa ? -magnitude : magnitude);
+        x.result[base + k] = static_cast<std::int8_t>(value);
+    }
+}
+
+namespace detail {
+
+[[gnu::always_inline]] inline void addBlocks(const AddArgs& x) {
+    for (std::size_t base = 0; base < x.stride; base += BLOCK) addBlock(x, base);
+}
+
+[[gnu::always_inline]] inline void compareBlocks(const CompareArgs& x) {
+    for (std::size_t base = 0; base < x.stride; base += BLOCK) compareBlock(x, base);
+}
+
+#ifdef SEM_2_MPSIMD_X86
+
+__attribute__((target("avx2"))) inline void addBlocksAvx2(const AddArgs& x) { addBlocks(x); }
+__attribute__((target("avx512f"))) inline void addBlocksAvx512(const AddArgs& x) { addBlocks(x); }
+__attribute__((target("avx2"))) inline void compareBlocksAvx2(const CompareArgs& x) { compareBlocks(x); }
+__attribute__((target("avx512f"))) inline void compareBlocksAvx512(const CompareArgs& x) { compareBlocks(x); }
+
+#endif
+
+} // namespace detail
+
+// všechny bloky s jádrem pro nejlepší dostupnou úroveň
+inline void add(const AddArgs& x) {
+#ifdef SEM_2_MPSIMD_X86
+    switch (simd::level()) {
+        case simd::Level::AVX512: detail::addBlocksAvx512(x); return;
+        case simd::Level::AVX2: detail::addBlocksAvx2(x); return;
+        case simd::Level::Scalar: break;
+    }
+#endif
+    detail::addBlocks(x);
+}
+
+inline void compare(const CompareArgs& x) {
+#ifdef SEM_2_MPSIMD_X86
+    switch (simd::level()) {
+        case simd::Level::AVX512: detail::compareBlocksAvx512(x); return;
+        case simd::Level::AVX2: detail::compareBlocksAvx2(x); return;
+        case simd::Level::Scalar: break;
+    }
+#endif
+    detail::compareBlocks(x);
+}
+
+} // namespace mpn::batch
+
+/*
+ * Dávka count čísel MPInt<PRECISION> (jen omezená přesnost) ve sloupcovém uložení.
+ * Operace add, sub a mul zapisují výsledek do *this (smí to být i jeden z operandů),
+ * overflow dostane pro každé číslo 0 nebo 1 a vrací se počet přetečených čísel.
+ */
+template<size_t PRECISION>
+class MPIntBatch {
+    static_assert(PRECISION != MPInt<PRECISION>::Unlimited, "MPIntBatch needs a limited precision");
+
+public:
+    using limb_t = mpn::limb_t;
+    static constexpr size_t LIMBS = MPInt<PRECISION>::LIMBS;
+    static constexpr limb_t TOP_MASK = MPInt<PRECISION>::TOP_MASK;
+
+    MPIntBatch() = default;
+
+    // count nul
+    explicit MPIntBatch(size_t count) {
+        resize(count);
+    }
+
+    explicit MPIntBatch(std::span<const MPInt<PRECISION>> values) {
+        resize(values.size());
+        for (size_t i = 0; i < values.size(); ++i) set(i, values[i]);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // změna počtu čísel, nová čísla jsou nuly
+    void resize(size_t new_count) {
+        // odebraná čísla se vynulují, zarovnání řádků musí zůstat nulové
+        for (size_t i = new_count; i < count; ++i) clear(i);
+        const size_t new_stride = (new_count + mpn::batch::BLOCK - 1) / mpn::batch::BLOCK * mpn::batch::BLOCK;
+        if (new_stride != stride) {
+            std::vector<limb_t> moved(LIMBS * new_stride, 0);
+            const size_t keep = std::min(stride, new_stride);
+            for (size_t j = 0; j < LIMBS; ++j) {
+                std::copy_n(limbs.begin() + j * stride, keep, moved.begin() + j * new_stride);
+            }
+            limbs = std::move(moved);
+            signs.resize(new_stride, 0);
+            stride = new_stride;
+        }
+        count = new_count;
+    }
+
+    MPInt<PRECISION> get(size_t i) const {
+        MPInt<PRECISION> value;
+        for (size_t j = 0; j < LIMBS; ++j) value.data[j] = limbs[j * stride + i];
+        value.used = mpn::normalize(value.data.data(), LIMBS);
+        value.negative = signs[i] != 0 && value.used > 0;
+        return value;
+    }
+
+    void set(size_t i, const MPInt<PRECISION>& value) {
+        const size_t len = value.limbCount();
+        for (size_t j = 0; j < LIMBS; ++j) limbs[j * stride + i] = j < len ? value.data[j] : 0;
+        signs[i] = value.negative;
+    }
+
+    std::vector<MPInt<PRECISION>> toVector() const {
+        std::vector<MPInt<PRECISION>> values(count);
+        for (size_t i = 0; i < count; ++i) values[i] = get(i);
+        return values;
+    }
+
+    // *this = a + b po prvcích
+    size_t add(const MPIntBatch& a, const MPIntBatch& b, std::vector<std::uint8_t>& overflow) {
+        return addSigned(a, b, false, overflow);
+    }
+
+    // *this = a - b po prvcích
+    size_t sub(const MPIntBatch& a, const MPIntBatch& b, std::vector<std::uint8_t>& overflow) {
+        return addSigned(a, b, true, overflow);
+    }
+
+    // *this = a * b po prvcích
+    size_t mul(const MPIntBatch& a, const MPIntBatch& b, std::vector<std::uint8_t>& overflow) {
+        checkSizes(a, b);
+        resize(a.count);
+        overflow.assign(count, 0);
+        size_t overflowed = 0;
+        // po blocích pruhů: řádky se čtou a zapisují souvisle, násobení je pak skalární po pruzích
+        limb_t x[mpn::batch::BLOCK][LIMBS], y[mpn::batch::BLOCK][LIMBS], r[mpn::batch::BLOCK][LIMBS];
+        for (size_t i = 0; i < count; i += mpn::batch::BLOCK) {
+            const size_t lanes = std::min(mpn::batch::BLOCK, count - i);
+            for (size_t j = 0; j < LIMBS; ++j) {
+                for (size_t k = 0; k < lanes; ++k) {
+                    x[k][j] = a.limbs[j * stride + i + k];
+                    y[k][j] = b.limbs[j * stride + i + k];
+                }
+            }
+            for (size_t k = 0; k < lanes; ++k) {
+                const bool over = mulLane(r[k], x[k], y[k]);
+                overflow[i + k] = over;
+                overflowed += over;
+            }
+            for (size_t k = 0; k < lanes; ++k) {
+                bool nonzero = false;
+                for (size_t j = 0; j < LIMBS; ++j) {
+                    limbs[j * stride + i + k] = r[k][j];
+                    nonzero |= r[k][j] != 0;
+                }
+                signs[i + k] = (a.signs[i + k] != b.signs[i + k]) && nonzero;
+            }
+        }
+        return overflowed;
+    }
+
+    // result[i] = -1, 0 nebo 1 podle a[i] <=> b[i]
+    static void compare(const MPIntBatch& a, const MPIntBatch& b, std::vector<std::int8_t>& result) {
+        checkSizes(a, b);
+        result.resize(a.stride);
+        mpn::batch::compare({a.limbs.data(), b.limbs.data(), a.signs.data(), b.signs.data(),
+                             result.data(), a.stride, LIMBS});
+        result.resize(a.count);
+    }
+
+private:
+    std::vector<limb_t> limbs;          // limbs[j * stride + i] je limb j čísla i
+    std::vector<std::uint8_t> signs;    // 1 = záporné
+    size_t count = 0;
+    size_t stride = 0;                  // count zarovnaný na násobek BLOCK
+
+    static void checkSizes(const MPIntBatch& a, const MPIntBatch& b) {
+        if (a.count != b.count) {
+            throw std::invalid_argument("MPIntBatch size mismatch");
+        }
+    }
+
+    /*
+     * r = x * y oříznuté na LIMBS limbů, vrací true při přetečení.
+     * Součiny x_i * y_j s i + j >= LIMBS se nepočítají, přetečení z nich se pozná
+     * z délek operandů. Přenosy nad LIMBS jsou nezáporné, stačí je tedy sečíst bitově.
+     */
+    static bool mulLane(limb_t* r, const limb_t* x, const limb_t* y) {
+        const size_t lx = mpn::normalize(x, LIMBS);
+        const size_t ly = mpn::normalize(y, LIMBS);
+        std::fill(r, r + LIMBS, limb_t{0});
+        if (lx == 0 || ly == 0) return false;
+
+        limb_t high = 0;
+        for (size_t i = 0; i < lx; ++i) {
+            const size_t n = std::min(ly, LIMBS - i);
+            limb_t carry = 0;
+            for (size_t j = 0; j < n; ++j) {
+                const mpn::dlimb_t prod = static_cast<mpn::dlimb_t>(x[i]) * y[j] + r[i + j] + carry;
+                r[i + j] = static_cast<limb_t>(prod);
+                carry = static_cast<limb_t>(prod >> mpn::LIMB_BITS);
+            }
+            // r[i + n] zatím žádný řádek nezapsal
+            if (i + n < LIMBS) r[i + n] = carry;
+            else high |= carry;
+        }
+        const bool overflow = high != 0 || lx + ly > LIMBS + 1 || r[LIMBS - 1] > TOP_MASK;
+        r[LIMBS - 1] &= TOP_MASK;
+        return overflow;
+    }
+
+    void clear(size_t i) {
+        for (size_t j = 0; j < LIMBS; ++j) limbs[j * stride + i] = 0;
+        signs[i] = 0;
+    }
+
+    size_t addSigned(const MPIntBatch& a, const MPIntBatch& b, bool negate_b, std::vector<std::uint8_t>& overflow) {
+        checkSizes(a, b);
+        resize(a.count);
+        overflow.resize(stride);
+        mpn::batch::add({limbs.data(), a.limbs.data(), b.limbs.data(), signs.data(), a.signs.data(),
+                         b.signs.data(), overflow.data(), stride, LIMBS, TOP_MASK, negate_b});
+        overflow.resize(count);
+        size_t overflowed = 0;
+        for (const std::uint8_t flag : overflow) overflowed += flag;
+        return overflowed;
+    }
+};
+
+#endif
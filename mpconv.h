@@ -0,0 +1,304 @@
+#ifndef SEM_2_MPCONV_H
+#define SEM_2_MPCONV_H
+
+#include <vector>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <charconv>
+#include <algorithm>
+#include <bit>
+#include "mpn.h"
+#include "mparena.h"
+#include "mpmul.h"
+#include "mpdiv.h"
+
+/*
+ * Převody mezi poli limbů a desítkovým zápisem.
+ * - Malá čísla se dělí po kusech 10^19 (největší mocnina deseti v limbu),
+ *   jedno dělení jednolimbovým číslem tedy vyrobí 19 cifer.
+ * - Velká čísla se rekurzivně půlí dělením mocninami 10^(19 * 2^k), které jsou
+ *   i se svými převrácenými hodnotami uložené v tabulce sdílené mezi voláními.
+ *   Dělení je Barrettovo, takže celý převod běží v čase O(M(n) log n).
+ * - Načítání jde opačně: po 19 cifrách násobením 10^19 a přičtením, dlouhé
+ *   řetězce se rekurzivně půlí a spojí jako hi * 10^(19 * 2^k) + lo.
+ * - Šestnáctková soustava nepotřebuje násobení ani dělení: limb je přesně 16 cifer,
+ *   takže převod oběma směry je lineární.
+ */
+namespace mpn {
+
+namespace conv {
+
+constexpr limb_t CHUNK_BASE = 10000000000000000000ull;   // 10^19
+constexpr unsigned CHUNK_DIGITS = 19;
+
+// od kolika limbů se převod do desítkové soustavy dělí rekurzivně
+constexpr std::size_t TO_DECIMAL_DC_THRESHOLD = 30;
+// od kolika cifer se načítání z desítkové soustavy dělí rekurzivně
+constexpr std::size_t FROM_DECIMAL_DC_THRESHOLD = 600;
+
+struct PowerOfTen {
+    std::vector<limb_t> value;  // 10^(19 * 2^k)
+    std::vector<limb_t> inv;    // floor(B^(2m) / value) pro Barrettovo dělení, počítá se až při potřebě
+};
+
+/*
+ * Tabulka mocnin 10^(19 * 2^k), jednou spočítané položky se už nemění.
+ * Převrácená hodnota je potřeba jen pro výpis, při načítání se nepočítá.
+ */
+inline const PowerOfTen& powerOfTen(std::size_t k, bool with_inverse = true) {
+    static std::mutex mutex;
+    static std::deque<PowerOfTen> table;   // deque nezneplatní reference při přidání
+
+    std::lock_guard<std::mutex> lock(mutex);
+    while (table.size() <= k) {
+        PowerOfTen next;
+        if (table.empty()) {
+            next.value = {CHUNK_BASE};
+        }
+        else {
+            const std::vector<limb_t>& prev = table.back().value;
+            next.value.resize(2 * prev.size());
+            mul(next.value.data(), prev.data(), prev.size(), prev.data(), prev.size());
+            next.value.resize(normalize(next.value.data(), next.value.size()));
+        }
+        table.push_back(std::move(next));
+    }
+
+    PowerOfTen& entry = table[k];
+    if (with_inverse && entry.inv.empty()) {
+        entry.inv.resize(entry.value.size() + 2);
+        invert(entry.inv.data(), entry.value.data(), entry.value.size());
+    }
+    return entry;
+}
+
+// rozklad x do cifer v soustavě 10^19 opakovaným dělením, zapíše právě count cifer
+inline void toChunksBasecase(limb_t* chunks, std::size_t count, const limb_t* x, std::size_t n) {
+    std::array<limb_t, TO_DECIMAL_DC_THRESHOLD> tmp{};
+    std::copy_n(x, n, tmp.begin());
+    for (std::size_t i = 0; i < count; ++i) {
+        chunks[i] = n > 0 ? divrem_1(tmp.data(), tmp.data(), n, CHUNK_BASE) : 0;
+        n = normalize(tmp.data(), n);
+    }
+}
+
+/*
+ * Zapíše 2^(k+1) cifer v soustavě 10^19 (od nejnižší) čísla x < (10^(19 * 2^k))^2.
+ * x = q * 10^(19 * 2^k) + r, dolní polovinu cifer dá r a horní q.
+ */
+inline void toChunks(limb_t* chunks, const limb_t* x, std::size_t n, std::size_t k) {
+    n = normalize(x, n);
+    const std::size_t count = std::size_t{2} << k;
+    if (n <= TO_DECIMAL_DC_THRESHOLD) {
+        toChunksBasecase(chunks, count, x, n);
+        return;
+    }
+
+    const PowerOfTen& power = powerOfTen(k);
+    const std::size_t m = power.value.size();
+    if (n < m) {
+        // x < 10^(19 * 2^k), horní polovina cifer jsou nuly
+        toChunks(chunks, x, n, k - 1);
+        std::fill(chunks + count / 2, chunks + count, limb_t{0});
+        return;
+    }
+
+    ScratchBuffer q(n - m + 1);
+    ScratchBuffer r(m);
+    divrem_barrett(q.data(), r.data(), x, n, power.value.data(), m, power.inv.data());
+    toChunks(chunks, r.data(), m, k - 1);
+    toChunks(chunks + count / 2, q.data(), q.size(), k - 1);
+}
+
+// připojí cifry v soustavě 10^19 (od nejnižší) jako desítkový zápis bez úvodních nul
+inline void appendChunks(std::string& out, const limb_t* chunks, std::size_t count) {
+    while (count > 1 && chunks[count - 1] == 0) --count;
+
+    char buf[CHUNK_DIGITS + 1];
+    const auto top = std::to_chars(buf, buf + sizeof(buf), chunks[count - 1]);
+    out.append(buf, top.ptr);
+    for (std::size_t i = count - 1; i > 0; --i) {
+        limb_t chunk = chunks[i - 1];
+        for (unsigned d = CHUNK_DIGITS; d > 0; --d) {
+            buf[d - 1] = static_cast<char>('0' + chunk % 10);
+            chunk /= 10;
+        }
+        out.append(buf, CHUNK_DIGITS);
+    }
+}
+
+// hodnota nejvýše 19 desítkových cifer (znaky musí být ověřené)
+constexpr limb_t parseChunk(const char* s, std::size_t len) {
+    limb_t value = 0;
+    for (std::size_t i = 0; i < len; ++i) value = value * 10 + static_cast<limb_t>(s[i] - '0');
+    return value;
+}
+
+} // namespace conv
+
+// počet limbů, do kterých se vejde číslo s count desítkovými ciframi (10^19 < 2^64)
+constexpr std::size_t decimalLimbs(std::size_t count) {
+    return (count + conv::CHUNK_DIGITS - 1) / conv::CHUNK_DIGITS;
+}
+
+namespace conv {
+
+inline std::size_t fromDecimalSplit(limb_t* out, const char* s, std::size_t count);
+
+} // namespace conv
+
+/*
+ * Načte count desítkových cifer (už ověřených) do out, které má decimalLimbs(count) limbů.
+ * Vrací počet platných limbů. Při překladu (constexpr) se načítá jen po 19 cifrách.
+ */
+constexpr std::size_t fromDecimal(limb_t* out, const char* s, std::size_t count) {
+    using namespace conv;
+
+    if (count <= FROM_DECIMAL_DC_THRESHOLD || std::is_constant_evaluated()) {
+        // první kus má count % 19 cifer, ostatní přesně 19: out = out * 10^19 + kus
+        std::size_t n = 0;
+        std::size_t len = count % CHUNK_DIGITS == 0 ? CHUNK_DIGITS : count % CHUNK_DIGITS;
+        for (std::size_t pos = 0; pos < count; pos += len, len = CHUNK_DIGITS) {
+            const limb_t chunk = parseChunk(s + pos, len);
+            const limb_t carry = mul_1(out, out, n, CHUNK_BASE);
+            const limb_t top = carry + (n > 0 ? add(out, out, n, &chunk, 1) : chunk);
+            if (top != 0) out[n++] = top;
+        }
+        return n;
+    }
+    return fromDecimalSplit(out, s, count);
+}
+
+namespace conv {
+
+// dlouhý řetězec rozdělený na horní cifry a dolních 19 * 2^k cifer: hodnota = hi * 10^(19 * 2^k) + lo
+inline std::size_t fromDecimalSplit(limb_t* out, const char* s, std::size_t count) {
+    const std::size_t cap = decimalLimbs(count);
+    std::size_t k = 0;
+    while ((CHUNK_DIGITS << (k + 1)) < count) ++k;
+    const std::size_t lo_digits = CHUNK_DIGITS << k;
+    const std::size_t hi_digits = count - lo_digits;
+
+    ScratchBuffer hi(decimalLimbs(hi_digits));
+    ScratchBuffer lo(decimalLimbs(lo_digits));
+    const std::size_t hi_len = fromDecimal(hi.data(), s, hi_digits);
+    const std::size_t lo_len = fromDecimal(lo.data(), s + hi_digits, lo_digits);
+
+    std::fill(out, out + cap, limb_t{0});
+    if (hi_len > 0) {
+        const std::vector<limb_t>& power = powerOfTen(k, false).value;
+        // délka součinu je nejvýše decimalLimbs(hi_digits) + 2^k = cap
+        if (hi_len >= power.size())
+            mul(out, hi.data(), hi_len, power.data(), power.size());
+        else
+            mul(out, power.data(), power.size(), hi.data(), hi_len);
+    }
+    add(out, out, cap, lo.data(), lo_len);
+    return normalize(out, cap);
+}
+
+} // namespace conv
+
+/*
+ * Připojí desítkový zápis čísla x (n limbů) na konec out.
+ * Malá čísla se převádí na zásobníku, velká v odkládací aréně vlákna, takže při dostatečné
+ * kapacitě out (a už zahřáté aréně) převod nealokuje.
+ */
+inline void toDecimal(std::string& out, const limb_t* x, std::size_t n) {
+    using namespace conv;
+    n = normalize(x, n);
+    if (n == 0) {
+        out.push_back('0');
+        return;
+    }
+
+    if (n <= TO_DECIMAL_DC_THRESHOLD) {
+        // 64 bitů je 19.3 cifer, takže n + 2 cifer v soustavě 10^19 vždy stačí
+        std::array<limb_t, TO_DECIMAL_DC_THRESHOLD + 2> chunks{};
+        toChunksBasecase(chunks.data(), n + 2, x, n);
+        appendChunks(out, chunks.data(), n + 2);
+        return;
+    }
+
+    // nejmenší k, pro které má mocnina m limbů a (10^(19 * 2^k))^2 >= B^(2(m - 1)) > x
+    std::size_t k = 0;
+    while (2 * (powerOfTen(k).value.size() - 1) < n) ++k;
+
+    ScratchBuffer chunks(std::size_t{2} << k);
+    toChunks(chunks.data(), x, n, k);
+    appendChunks(out, chunks.data(), chunks.size());
+}
+
+// počet limbů pro count šestnáctkových cifer (16 cifer na limb)
+constexpr std::size_t hexLimbs(std::size_t count) {
+    return (count + LIMB_BITS / 4 - 1) / (LIMB_BITS / 4);
+}
+
+namespace conv {
+
+// hodnoty šestnáctkových cifer podle znaku (tabulka místo porovnání, cifry 0-9 a a-f se střídají nahodile)
+constexpr std::array<signed char, 256> HEX_VALUES = [] {
+    std::array<signed char, 256> table{};
+    table.fill(-1);
+    for (int i = 0; i < 10; ++i) table['0' + i] = static_cast<signed char>(i);
+    for (int i = 0; i < 6; ++i) {
+        table['a' + i] = static_cast<signed char>(10 + i);
+        table['A' + i] = static_cast<signed char>(10 + i);
+    }
+    return table;
+}();
+
+} // namespace conv
+
+// hodnota šestnáctkové cifry (malá i velká písmena), -1 pro jiný znak
+constexpr int hexDigit(char c) {
+    return conv::HEX_VALUES[static_cast<unsigned char>(c)];
+}
+
+/*
+ * Načte count šestnáctkových cifer (už ověřených) do out, které má hexLimbs(count) limbů.
+ * Limb i skládá cifry [count - 16(i + 1), count - 16i), vrací počet platných limbů.
+ */
+constexpr std::size_t fromHex(limb_t* out, const char* s, std::size_t count) {
+    constexpr std::size_t DIGITS = LIMB_BITS / 4;
+    const std::size_t n = hexLimbs(count);
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::size_t end = count - DIGITS * i;
+        const std::size_t begin = end > DIGITS ? end - DIGITS : 0;
+        limb_t value = 0;
+        for (std::size_t pos = begin; pos < end; ++pos) {
+            value = value << 4 | static_cast<limb_t>(hexDigit(s[pos]));
+        }
+        out[i] = value;
+    }
+    return normalize(out, n);
+}
+
+// připojí šestnáctkový zápis x (n limbů, malá písmena, bez úvodních nul) na konec out
+inline void toHex(std::string& out, const limb_t* x, std::size_t n) {
+    constexpr char DIGITS[] = "0123456789abcdef";
+    n = normalize(x, n);
+    if (n == 0) {
+        out.push_back('0');
+        return;
+    }
+
+    // nejvyšší limb bez úvodních nul, ostatní přesně 16 cifer; píše se odzadu
+    const std::size_t top = (LIMB_BITS - std::countl_zero(x[n - 1]) + 3) / 4;
+    const std::size_t start = out.size();
+    out.resize(start + top + (n - 1) * (LIMB_BITS / 4));
+    char* p = out.data() + out.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        limb_t value = x[i];
+        for (std::size_t d = i + 1 < n ? LIMB_BITS / 4 : top; d > 0; --d) {
+            *--p = DIGITS[value & 15];
+            value >>= 4;
+        }
+    }
+}
+
+} // namespace mpn
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef SEM_2_MPDIV_H
+#define SEM_2_MPDIV_H
+
+#include <algorithm>
+#include <bit>
+#include "mpn.h"
+#include "mparena.h"
+#include "mpmul.h"
+
+/*
+ * Dělení nad poli limbů.
+ * - Dělení jedním limbem používá předpočítanou převrácenou hodnotu dělitele
+ *   (Möller, Granlund: Improved division by invariant integers), takže ve smyčce
+ *   není žádná 128bitová dělicí instrukce.
+ * - Dělení víceslovným číslem je Knuthův algoritmus D: normalizace, odhad cifry
+ *   podílu z horních limbů a její korekce.
+ * - Pro opakované dělení velkým konstantním dělitelem (mocniny deseti při převodu
+ *   do desítkové soustavy) je tu Barrettovo dělení s převrácenou hodnotou spočítanou
+ *   Newtonovou iterací, obojí v čase násobení.
+ */
+namespace mpn {
+
+// převrácená hodnota normalizovaného dělitele (nejvyšší bit nastavený): floor((B^2 - 1) / d) - B
+constexpr limb_t reciprocal(limb_t d) {
+    return static_cast<limb_t>(~static_cast<dlimb_t>(0) / d);
+}
+
+// (u1, u0) / d pro normalizované d a u1 < d, v = reciprocal(d)
+constexpr void div2by1(limb_t& q, limb_t& r, limb_t u1, limb_t u0, limb_t d, limb_t v) {
+    dlimb_t qq = static_cast<dlimb_t>(v) * u1;
+    qq += (static_cast<dlimb_t>(u1) << LIMB_BITS) | u0;
+    limb_t q1 = static_cast<limb_t>(qq >> LIMB_BITS) + 1;
+    const limb_t q0 = static_cast<limb_t>(qq);
+    limb_t rem = u0 - q1 * d;
+    if (rem > q0) {
+        --q1;
+        rem += d;
+    }
+    if (rem >= d) {
+        ++q1;
+        rem -= d;
+    }
+    q = q1;
+    r = rem;
+}
+
+/*
+ * q = a / d, vrací zbytek. q má n limbů a smí být totéž pole co a.
+ */
+constexpr limb_t divrem_1(limb_t* q, const limb_t* a, std::size_t n, limb_t d) {
+    if (n == 0) return 0;
+    const unsigned shift = std::countl_zero(d);
+    d <<= shift;
+    const limb_t v = reciprocal(d);
+
+    // dělenec posouváme o shift bitů průběžně, vysunuté bity tvoří počáteční zbytek
+    limb_t rem = shift ? a[n - 1] >> (LIMB_BITS - shift) : 0;
+    for (std::size_t i = n; i > 0; --i) {
+        limb_t u0 = a[i - 1] << shift;
+        if (shift && i > 1) u0 |= a[i - 2] >> (LIMB_BITS - shift);
+        div2by1(q[i - 1], rem, rem, u0, d, v);
+    }
+    return rem >> shift;
+}
+
+/*
+ * Knuthův algoritmus D: q = a / d, r = a % d.
+ * Předpokládá na >= nd >= 2 a d[nd - 1] != 0.
+ * q má na - nd + 1 limbů, r má nd limbů, nesmí se překrývat se vstupy.
+ */
+inline void divrem(limb_t* q, limb_t* r, const limb_t* a, std::size_t na, const limb_t* d, std::size_t nd) {
+    // normalizace: posun tak, aby nejvyšší limb dělitele měl nastavený nejvyšší bit
+    const unsigned shift = std::countl_zero(d[nd - 1]);
+    // normalizované kopie v odkládací aréně
+    ScratchBuffer dn(nd);
+    ScratchBuffer un(na + 1);
+    if (shift) {
+        lshift(dn.data(), d, nd, shift);
+        un[na] = lshift(un.data(), a, na, shift);
+    }
+    else {
+        std::copy_n(d, nd, dn.begin());
+        std::copy_n(a, na, un.begin());
+        un[na] = 0;
+    }
+
+    const limb_t d_top = dn[nd - 1];
+    const limb_t d_second = dn[nd - 2];
+    const limb_t v = reciprocal(d_top);
+
+    for (std::size_t j = na - nd + 1; j > 0; --j) {
+        limb_t* u = un.data() + (j - 1);
+        const limb_t u2 = u[nd];
+        const limb_t u1 = u[nd - 1];
+        const limb_t u0 = u[nd - 2];
+
+        // odhad cifry podílu z horních dvou limbů zbytku
+        limb_t qhat, rhat;
+        bool rhat_overflow = false;
+        if (u2 >= d_top) {
+            // u2 == d_top, odhad by přetekl -> maximální cifra
+            qhat = ~limb_t{0};
+            rhat = u1 + d_top;
+            rhat_overflow = rhat < u1;
+        }
+        else {
+            div2by1(qhat, rhat, u2, u1, d_top, v);
+        }
+        // korekce pomocí druhého limbu dělitele (odhad je pak nejvýše o 1 větší)
+        while (!rhat_overflow &&
+               static_cast<dlimb_t>(qhat) * d_second > ((static_cast<dlimb_t>(rhat) << LIMB_BITS) | u0)) {
+            --qhat;
+            rhat += d_top;
+            rhat_overflow = rhat < d_top;
+        }
+
+        // vynásobit a odečíst, při záporném výsledku přičíst dělitel zpět
+        const limb_t borrow = submul_1(u, dn.data(), nd, qhat);
+        const limb_t top = u[nd];
+        u[nd] = top - borrow;
+        if (top < borrow) {
+            --qhat;
+            u[nd] += add(u, u, nd, dn.data(), nd);
+        }
+        q[j - 1] = qhat;
+    }
+
+    // zbytek je v dolních nd limbech, vrátíme normalizační posun
+    if (shift)
+        rshift(r, un.data(), nd, shift);
+    else
+        std::copy_n(un.begin(), nd, r);
+}
+
+namespace detail {
+
+// r = |x - B^k| pro x délky n, vrací true pokud x > B^k; r musí mít max(n, k + 1) limbů
+inline bool diffFromPower(limb_t* r, const limb_t* x, std::size_t n, std::size_t k) {
+    const std::size_t len = std::max(n, k + 1);
+    ScratchBuffer power(len, 0);
+    power[k] = 1;
+    std::fill(r, r + len, limb_t{0});
+    if (cmp(x, n, power.data(), len) > 0) {
+        sub(r, x, n, power.data(), k + 1);
+        return true;
+    }
+    sub(r, power.data(), len, x, normalize(x, n));
+    return false;
+}
+
+// q += floor(x / d), případně q -= ceil(x / d) pro subtract; q má qn limbů
+inline void addQuotient(limb_t* q, std::size_t qn, const limb_t* x, std::size_t n, const limb_t* d, std::size_t m,
+                        bool subtract) {
+    n = normalize(x, n);
+    const bool at_least_d = cmp(x, n, d, m) >= 0;
+    // podíl má nejvýše n - m + 1 limbů, jeden limb navíc pro zaokrouhlení nahoru
+    const std::size_t quot_size = (at_least_d ? n - m + 1 : 1) + 1;
+    ScratchBuffer quot(quot_size, 0);
+    bool has_rem = n > 0;
+    if (at_least_d) {
+        ScratchBuffer rem(m);
+        if (m == 1)
+            rem[0] = divrem_1(quot.data(), x, n, d[0]);
+        else
+            divrem(quot.data(), rem.data(), x, n, d, m);
+        has_rem = normalize(rem.data(), m) > 0;
+    }
+    // při odečítání potřebujeme ceil(x / d)
+    if (subtract && has_rem) {
+        const limb_t one = 1;
+        add(quot.data(), quot.data(), quot_size, &one, 1);
+    }
+    const std::size_t quot_len = normalize(quot.data(), quot_size);
+    if (subtract)
+        sub(q, q, qn, quot.data(), quot_len);
+    else
+        add(q, q, qn, quot.data(), quot_len);
+}
+
+} // namespace detail
+
+/*
+ * inv = floor(B^(2m) / d) pro d délky m s nenulovým nejvyšším limbem, inv má m + 2 limbů.
+ * Rekurzivně spočítá převrácenou hodnotu horní poloviny dělitele, zpřesní ji jedním
+ * Newtonovým krokem a výsledek opraví přesným dopočtem zbytku (oprava je malá, proto
+ * ji stačí dodělat algoritmem D v lineárním čase).
+ */
+inline void invert(limb_t* inv, const limb_t* d, std::size_t m) {
+    constexpr std::size_t INVERT_BASECASE = 16;
+    std::fill(inv, inv + m + 2, limb_t{0});
+
+    if (m <= INVERT_BASECASE) {
+        // přímé dělení B^(2m) / d
+        ScratchBuffer num(2 * m + 1, 0);
+        num[2 * m] = 1;
+        if (m == 1) {
+            divrem_1(inv, num.data(), 2 * m + 1, d[0]);
+        }
+        else {
+            ScratchBuffer rem(m);
+            divrem(inv, rem.data(), num.data(), 2 * m + 1, d, m);
+        }
+        return;
+    }
+
+    // převrácená hodnota horních h limbů: Ih = floor(B^(2h) / dh)
+    const std::size_t h = m - m / 2;
+    const limb_t* dh = d + (m - h);
+    ScratchBuffer ih(h + 2);
+    invert(ih.data(), dh, h);
+    const std::size_t ih_len = normalize(ih.data(), h + 2);
+
+    // X0 = Ih * B^(m - h), chyba E = B^(2m) - d * X0 = (B^(m + h) - d * Ih) * B^(m - h)
+    ScratchBuffer prod(m + ih_len);
+    mul(prod.data(), d, m, ih.data(), ih_len);
+    ScratchBuffer e0(std::max(prod.size(), m + h + 1));
+    const bool e_negative = detail::diffFromPower(e0.data(), prod.data(), prod.size(), m + h);
+
+    // Newtonův krok: X1 = X0 + X0 * E / B^(2m) = X0 + Ih * E0 / B^(2h), E0 zkrátíme o s limbů
+    std::copy_n(ih.data(), ih_len, inv + (m - h));
+    const std::size_t s = h >= 2 ? h - 2 : 0;
+    const std::size_t e_len = normalize(e0.data(), e0.size());
+    if (e_len > s) {
+        const limb_t* e_top = e0.data() + s;
+        const std::size_t e_top_len = e_len - s;
+        ScratchBuffer t(e_top_len + ih_len);
+        if (e_top_len >= ih_len)
+            mul(t.data(), e_top, e_top_len, ih.data(), ih_len);
+        else
+            mul(t.data(), ih.data(), ih_len, e_top, e_top_len);
+        const std::size_t shift = 2 * h - s;
+        if (t.size() > shift) {
+            const limb_t* corr = t.data() + shift;
+            const std::size_t corr_len = std::min(normalize(corr, t.size() - shift), m + 2);
+            if (e_negative)
+                sub(inv, inv, m + 2, corr, corr_len);
+            else
+                add(inv, inv, m + 2, corr, corr_len);
+        }
+    }
+
+    // přesná oprava: R = B^(2m) - d * X1, I = X1 + floor(R / d)
+    const std::size_t x1_len = std::max<std::size_t>(normalize(inv, m + 2), 1);
+    ScratchBuffer dx(m + x1_len);
+    if (x1_len >= m)
+        mul(dx.data(), inv, x1_len, d, m);
+    else
+        mul(dx.data(), d, m, inv, x1_len);
+    ScratchBuffer r(std::max(dx.size(), 2 * m + 1));
+    const bool r_negative = detail::diffFromPower(r.data(), dx.data(), dx.size(), 2 * m);
+    detail::addQuotient(inv, m + 2, r.data(), r.size(), d, m, r_negative);
+}
+
+/*
+ * Barrettovo dělení: q = x / d, r = x % d pro x délky n <= 2m, d délky m (nenulový nejvyšší limb)
+ * a inv = floor(B^(2m) / d) délky m + 2. q má n - m + 1 limbů (n >= m), r má m limbů.
+ */
+inline void divrem_barrett(limb_t* q, limb_t* r, const limb_t* x, std::size_t n,
+                           const limb_t* d, std::size_t m, const limb_t* inv) {
+    const std::size_t qn = n - m + 1;
+    const std::size_t inv_len = std::max<std::size_t>(normalize(inv, m + 2), 1);
+
+    // odhad podílu: floor(floor(x / B^(m - 1)) * inv / B^(m + 1)), je menší nejvýše o 2
+    const limb_t* xs = x + (m - 1);
+    const std::size_t xs_len = std::max<std::size_t>(normalize(xs, n - (m - 1)), 1);
+    ScratchBuffer t(xs_len + inv_len);
+    if (xs_len >= inv_len)
+        mul(t.data(), xs, xs_len, inv, inv_len);
+    else
+        mul(t.data(), inv, inv_len, xs, xs_len);
+    std::fill(q, q + qn, limb_t{0});
+    if (t.size() > m + 1) std::copy_n(t.data() + (m + 1), std::min(t.size() - (m + 1), qn), q);
+
+    // zbytek r = x - q * d
+    const std::size_t q_len = normalize(q, qn);
+    ScratchBuffer rem(n + 1, 0);
+    std::copy_n(x, n, rem.begin());
+    if (q_len > 0) {
+        ScratchBuffer qd(q_len + m);
+        if (q_len >= m)
+            mul(qd.data(), q, q_len, d, m);
+        else
+            mul(qd.data(), d, m, q, q_len);
+        sub(rem.data(), rem.data(), n + 1, qd.data(), normalize(qd.data(), qd.size()));
+    }
+
+    // korekce
+    while (cmp(rem.data(), n + 1, d, m) >= 0) {
+        sub(rem.data(), rem.data(), n + 1, d, m);
+        const limb_t one = 1;
+        add(q, q, qn, &one, 1);
+    }
+    std::copy_n(rem.begin(), m, r);
+}
+
+} // namespace mpn
+
+#endif
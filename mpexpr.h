@@ -0,0 +1,256 @@
+#ifndef SEM_2_MPEXPR_H
+#define SEM_2_MPEXPR_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include "mpint.h"
+
+/*
+ * Aritmetický výraz přeložený do zásobníkového bytekódu.
+ * - Překlad je Prattův parser nad tokeny z MPTerm::tokenize (čísla, $N, operátory, závorky).
+ * - Priority: + - < * / % < unární mínus < ^ (zprava asociativní) < postfixový !.
+ * - Mocnina, jejíž výsledek jde rovnou do % (a ^ b % m, (a ^ b) % m), se přeloží na jednu
+ *   modulární mocninu (Op::PowMod). Mezivýsledek a ^ b nevzniká, takže u omezené přesnosti
+ *   nepřeteče, a zbytek má znaménko jako u % (podle dělence a ^ b).
+ * - Parser je rekurzivní, závorky, unární znaménka a řetězy ^ smí být zanořené nejvýše
+ *   MAX_NESTING úrovní, hlubší řádek vyhodí std::invalid_argument místo přetečení zásobníku.
+ * - Literály se převedou na MPInt už při překladu, odkazy na historii se čtou až při
+ *   vyhodnocení, takže jeden přeložený výraz jde vyhodnotit opakovaně.
+ * - Vyhodnocení pracuje nad registry (std::vector<MPInt>), které dodá volající. Operace se
+ *   provádí na místě (+=, *=, ...), takže při opakovaném vyhodnocení se registry
+ *   nepřealokovávají a nevznikají dočasné MPInt.
+ */
+template<size_t PRECISION>
+class MPExpr {
+public:
+    enum class Op : std::uint8_t {
+        Const,      // push constants[arg]
+        History,    // push historie[arg] ($1 má arg 0)
+        Add, Sub, Mul, Div, Mod, Pow,
+        PowMod,     // (a ^ b) % m jedním powmod
+        Neg,        // unární mínus
+        Fact        // postfixový faktoriál
+    };
+
+    struct Instr {
+        Op op;
+        std::uint32_t arg = 0;
+    };
+
+    /*
+     * Překlad tokenů do bytekódu.
+     * Při syntaktické chybě nebo neplatném literálu vyhodí std::invalid_argument.
+     */
+    static MPExpr compile(const std::vector<std::string_view>& tokens) {
+        MPExpr expr;
+        compile(tokens, expr);
+        return expr;
+    }
+
+    /*
+     * Překlad do existujícího výrazu (původní obsah se zahodí). Výraz si nechá
+     * alokovanou paměť, takže opakovaný překlad krátkých řádků nealokuje.
+     */
+    static void compile(const std::vector<std::string_view>& tokens, MPExpr& expr) {
+        expr.code.clear();
+        expr.constants.clear();
+        expr.max_depth = 0;
+        expr.depth = 0;
+
+        Parser parser{tokens, expr};
+        parser.parseExpression(0);
+        if (parser.pos != tokens.size()) {
+            throw std::invalid_argument("Unexpected token in expression: " + std::string(tokens[parser.pos]));
+        }
+    }
+
+    /*
+     * Vyhodnocení výrazu. registers je pracovní zásobník (podle potřeby se zvětší
+     * a mezi voláními si drží alokovanou paměť), history(i) vrací hodnotu $(i + 1).
+     * Vrací referenci na výsledek uložený v registers[0].
+     * Přetečení a chyby (dělení nulou, ...) se šíří jako výjimky MPInt.
+     */
+    template<typename HistoryLookup>
+    const MPInt<PRECISION>& evaluate(std::vector<MPInt<PRECISION>>& registers, HistoryLookup&& history,
+                                     unsigned factorial_threads = 0) const {
+        if (registers.size() < max_depth) registers.resize(max_depth);
+
+        size_t top = 0;   // počet obsazených registrů
+        for (const Instr& in : code) {
+            switch (in.op) {
+                case Op::Const:   registers[top++] = constants[in.arg]; break;
+                case Op::History: registers[top++] = history(in.arg); break;
+                case Op::Add:     --top; registers[top - 1] += registers[top]; break;
+                case Op::Sub:     --top; registers[top - 1] -= registers[top]; break;
+                case Op::Mul:     --top; registers[top - 1] *= registers[top]; break;
+                case Op::Div:     --top; registers[top - 1] /= registers[top]; break;
+                case Op::Mod:     --top; registers[top - 1] %= registers[top]; break;
+                case Op::Pow:     --top; registers[top - 1] = registers[top - 1].pow(registers[top]); break;
+                case Op::PowMod:  top -= 2; powMod(registers[top - 1], registers[top], registers[top + 1]); break;
+                case Op::Neg:     registers[top - 1].negate(); break;
+                case Op::Fact:    registers[top - 1] = registers[top - 1].factorial(factorial_threads); break;
+            }
+        }
+        return registers[0];
+    }
+
+    // true, pokud výraz čte historii ($N)
+    bool usesHistory() const {
+        return std::ranges::any_of(code, [](const Instr& in) { return in.op == Op::History; });
+    }
+
+    const std::vector<Instr>& instructions() const {
+        return code;
+    }
+
+private:
+    std::vector<Instr> code;
+    std::vector<MPInt<PRECISION>> constants;
+    size_t max_depth = 0;   // nejvyšší počet současně obsazených registrů
+    size_t depth = 0;       // obsazenost zásobníku během překladu
+
+    // nejvyšší zanoření parseru (i vlákna paralelního dávkového režimu mají dost zásobníku)
+    static constexpr size_t MAX_NESTING = 1000;
+
+    // priority binárních a postfixových operátorů
+    static constexpr int PREC_ADD = 1;
+    static constexpr int PREC_MUL = 2;
+    static constexpr int PREC_UNARY = 3;
+    static constexpr int PREC_POW = 4;
+
+    /*
+     * x = (x ^ exp) % mod bez mezivýsledku x ^ exp. powmod vrací zbytek v [0, |mod|),
+     * % má ale znaménko dělence, takže zbytek záporné mocniny se posune o |mod| dolů.
+     */
+    static void powMod(MPInt<PRECISION>& x, const MPInt<PRECISION>& exp, const MPInt<PRECISION>& mod) {
+        const bool negative = x.getNegative() && (exp.getDataOnPos(0) & 1) != 0;
+        x = x.powmod(exp, mod);
+        if (negative && x != MPInt<PRECISION>(0)) {
+            if (mod.getNegative()) x += mod;
+            else x -= mod;
+        }
+    }
+
+    void emit(Op op, std::uint32_t arg = 0) {
+        code.push_back({op, arg});
+        if (op == Op::Const || op == Op::History) {
+            max_depth = std::max(max_depth, ++depth);
+        }
+        else if (op != Op::Neg && op != Op::Fact) {
+            --depth;
+        }
+    }
+
+    static bool binaryOperator(std::string_view token, Op& op, int& prec) {
+        if (token.size() != 1) return false;
+        switch (token[0]) {
+            case '+': op = Op::Add; prec = PREC_ADD; return true;
+            case '-': op = Op::Sub; prec = PREC_ADD; return true;
+            case '*': op = Op::Mul; prec = PREC_MUL; return true;
+            case '/': op = Op::Div; prec = PREC_MUL; return true;
+            case '%': op = Op::Mod; prec = PREC_MUL; return true;
+            case '^': op = Op::Pow; prec = PREC_POW; return true;
+            default: return false;
+        }
+    }
+
+    struct Parser {
+        const std::vector<std::string_view>& tokens;
+        MPExpr& expr;
+        size_t pos = 0;
+        size_t nesting = 0;   // aktuální hloubka rekurze parseExpression
+
+        std::string_view next() {
+            if (pos >= tokens.size()) {
+                throw std::invalid_argument("Unexpected end of expression");
+            }
+            return tokens[pos++];
+        }
+
+        // operand: literál, $N, závorka nebo unární znaménko
+        void parsePrefix() {
+            const std::string_view t = next();
+            if (t == "(") {
+                parseExpression(0);
+                if (pos >= tokens.size() || tokens[pos] != ")") {
+                    throw std::invalid_argument("Missing closing parenthesis");
+                }
+                ++pos;
+            }
+            else if (t == "-" || t == "+") {
+                parseExpression(PREC_UNARY);
+                if (t == "-") expr.emit(Op::Neg);
+            }
+            else if (t[0] == '$') {
+                std::uint32_t index = 0;
+                const auto [ptr, ec] = std::from_chars(t.data() + 1, t.data() + t.size(), index);
+                if (ec != std::errc() || ptr != t.data() + t.size() || index == 0) {
+                    throw std::invalid_argument("Invalid history reference: " + std::string(t));
+                }
+                expr.emit(Op::History, index - 1);
+            }
+            else if (t[0] >= '0' && t[0] <= '9') {
+                MPInt<PRECISION> value;
+                try {
+                    value = t;
+                } catch (const std::exception& e) {
+                    throw std::invalid_argument("Invalid number " + std::string(t) + ": " + e.what());
+                }
+                expr.constants.push_back(std::move(value));
+                expr.emit(Op::Const, static_cast<std::uint32_t>(expr.constants.size() - 1));
+            }
+            else {
+                throw std::invalid_argument("Unexpected token in expression: " + std::string(t));
+            }
+        }
+
+        /*
+         * Levý operand % je mocnina: a b Pow [m] Mod se přeloží na a b [m] PowMod.
+         * Kód modulu pak běží s o jeden registr hlubším zásobníkem.
+         */
+        void parsePowMod() {
+            const size_t pow_at = expr.code.size() - 1;
+            const size_t outer_depth = expr.max_depth;
+            expr.max_depth = 0;
+            parseExpression(PREC_MUL + 1);
+            expr.max_depth = std::max(outer_depth, expr.max_depth + 1);
+            expr.code.erase(expr.code.begin() + static_cast<std::ptrdiff_t>(pow_at));
+            expr.emit(Op::PowMod);
+        }
+
+        // výraz, ve kterém mají všechny binární operátory prioritu aspoň min_prec
+        void parseExpression(int min_prec) {
+            if (++nesting > MAX_NESTING) {
+                throw std::invalid_argument("Expression is nested too deeply");
+            }
+            parsePrefix();
+            while (pos < tokens.size()) {
+                const std::string_view t = tokens[pos];
+                if (t == "!") {
+                    ++pos;
+                    expr.emit(Op::Fact);
+                    continue;
+                }
+                Op op;
+                int prec;
+                if (!binaryOperator(t, op, prec) || prec < min_prec) break;
+                ++pos;
+                if (op == Op::Mod && expr.code.back().op == Op::Pow) {
+                    parsePowMod();
+                    continue;
+                }
+                // ^ je zprava asociativní, ostatní zleva
+                parseExpression(op == Op::Pow ? prec : prec + 1);
+                expr.emit(op);
+            }
+            --nesting;
+        }
+    };
+};
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef SEM_2_MPFACT_H
+#define SEM_2_MPFACT_H
+
+#include <vector>
+#include <future>
+#include <thread>
+#include <cmath>
+#include <bit>
+#include <algorithm>
+#include "mpn.h"
+#include "mpmul.h"
+#include "mparena.h"
+
+/*
+ * Výpočet faktoriálu.
+ * - Z každého činitele se odstraní mocnina dvojky, ta se na konci přidá jedním posunem
+ *   (n! = 2^(n - popcount(n)) * součin lichých částí).
+ * - Liché části se násobí v nativních 64bitových slovech, dokud se součin vejde do limbu,
+ *   a vzniklé limby se spojí vyváženým stromem součinů (stejně velké operandy
+ *   využijí Karatsubu, Toom-3 i NTT).
+ * - Rozsah 1..n se dělí na části se stejným součtem logaritmů a každý podstrom
+ *   se násobí ve vlastním vlákně.
+ * - Listy i mezivýsledky stromu leží v odkládací aréně vlákna, skutečně se alokují
+ *   jen součiny předávané mezi vlákny a výsledek.
+ */
+namespace mpn {
+
+namespace fact {
+
+// pod touto hranicí se vlákna nevyplatí
+constexpr std::uint64_t PARALLEL_THRESHOLD = 20000;
+// kolik limbů se v listu stromu násobí postupně jedním limbem
+constexpr std::size_t LEAF_SIZE = 16;
+
+/*
+ * Součin limbů values[lo, hi) vyváženým stromem do out (hi - lo + 1 limbů), vrací jeho délku.
+ * Podstromy se počítají do jednoho bufferu v aréně, který se uvolní dřív než buffer rodiče.
+ */
+inline std::size_t productTree(limb_t* out, const limb_t* values, std::size_t lo, std::size_t hi) {
+    if (hi - lo <= LEAF_SIZE) {
+        out[0] = 1;
+        std::size_t len = 1;
+        for (std::size_t i = lo; i < hi; ++i) {
+            const limb_t carry = mul_1(out, out, len, values[i]);
+            if (carry != 0) out[len++] = carry;
+        }
+        return len;
+    }
+
+    const std::size_t mid = lo + (hi - lo) / 2;
+    ScratchBuffer parts(hi - lo + 2);
+    limb_t* left = parts.data();
+    limb_t* right = parts.data() + (mid - lo + 1);
+    const std::size_t left_len = productTree(left, values, lo, mid);
+    const std::size_t right_len = productTree(right, values, mid, hi);
+    // součin k limbů má nejvýše k limbů, out tedy stačí
+    if (left_len >= right_len)
+        mul(out, left, left_len, right, right_len);
+    else
+        mul(out, right, right_len, left, left_len);
+    return normalize(out, left_len + right_len);
+}
+
+// listy stromu: co nejvíc lichých částí z [lo, hi) v jednom limbu; leaves == nullptr je jen počítá
+inline std::size_t collectLeaves(limb_t* leaves, std::uint64_t lo, std::uint64_t hi) {
+    std::size_t count = 0;
+    limb_t acc = 1;
+    for (std::uint64_t i = lo; i < hi; ++i) {
+        const limb_t odd = i >> std::countr_zero(i);
+        const dlimb_t prod = static_cast<dlimb_t>(acc) * odd;
+        if ((prod >> LIMB_BITS) != 0) {
+            if (leaves) leaves[count] = acc;
+            ++count;
+            acc = odd;
+        }
+        else {
+            acc = static_cast<limb_t>(prod);
+        }
+    }
+    if (leaves) leaves[count] = acc;
+    return count + 1;
+}
+
+// součin lichých částí čísel z [lo, hi)
+inline std::vector<limb_t> oddProduct(std::uint64_t lo, std::uint64_t hi) {
+    // počet listů se nejdřív jen spočítá, aby buffer v aréně měl přesnou velikost
+    const std::size_t count = collectLeaves(nullptr, lo, hi);
+    ScratchBuffer leaves(count);
+    collectLeaves(leaves.data(), lo, hi);
+    ScratchBuffer product(count + 1);
+    const std::size_t len = productTree(product.data(), leaves.data(), 0, count);
+    return std::vector<limb_t>(product.data(), product.data() + len);
+}
+
+// přibližný součet ln(i) pro i < x (integrál ln), slouží k vyvážení částí
+inline double logWeight(std::uint64_t x) {
+    const double v = static_cast<double>(std::max<std::uint64_t>(x, 1));
+    return v * std::log(v) - v;
+}
+
+// rozdělí [lo, hi) tak, aby obě části měly přibližně stejný součet logaritmů
+inline std::uint64_t balancedSplit(std::uint64_t lo, std::uint64_t hi) {
+    const double target = (logWeight(lo) + logWeight(hi)) / 2;
+    std::uint64_t a = lo + 1, b = hi - 1;
+    while (a < b) {
+        const std::uint64_t mid = a + (b - a) / 2;
+        if (logWeight(mid) < target) a = mid + 1;
+        else b = mid;
+    }
+    return a;
+}
+
+// součin lichých částí z [lo, hi), podstromy se počítají paralelně v threads vláknech
+inline std::vector<limb_t> parallelOddProduct(std::uint64_t lo, std::uint64_t hi, unsigned threads) {
+    if (threads <= 1 || hi - lo < PARALLEL_THRESHOLD) {
+        return oddProduct(lo, hi);
+    }
+
+    const std::uint64_t mid = balancedSplit(lo, hi);
+    const unsigned left_threads = threads / 2;
+    auto left_future = std::async(std::launch::async, parallelOddProduct, lo, mid, left_threads);
+    const std::vector<limb_t> right = parallelOddProduct(mid, hi, threads - left_threads);
+    const std::vector<limb_t> left = left_future.get();
+
+    std::vector<limb_t> result(left.size() + right.size());
+    if (left.size() >= right.size())
+        mul(result.data(), left.data(), left.size(), right.data(), right.size());
+    else
+        mul(result.data(), right.data(), right.size(), left.data(), left.size());
+    result.resize(normalize(result.data(), result.size()));
+    return result;
+}
+
+} // namespace fact
+
+/*
+ * n! jako normalizované pole limbů.
+ * threads = 0 znamená počet vláken podle hardwaru.
+ */
+inline std::vector<limb_t> factorial(std::uint64_t n, unsigned threads = 0) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<limb_t> odd = n < 2 ? std::vector<limb_t>{1} : fact::parallelOddProduct(2, n + 1, threads);
+
+    // vrácení dvojek: posun o n - popcount(n) bitů
+    const std::uint64_t twos = n - std::popcount(n);
+    const std::size_t limb_shift = twos / LIMB_BITS;
+    const unsigned bit_shift = twos % LIMB_BITS;
+
+    std::vector<limb_t> result(limb_shift + odd.size() + 1, 0);
+    if (bit_shift != 0)
+        result[limb_shift + odd.size()] = lshift(result.data() + limb_shift, odd.data(), odd.size(), bit_shift);
+    else
+        std::copy(odd.begin(), odd.end(), result.begin() + limb_shift);
+    result.resize(normalize(result.data(), result.size()));
+    return result;
+}
+
+// horní odhad počtu bitů n! z log-gamma funkce
+inline double factorialBits(std::uint64_t n) {
+    return std::lgamma(static_cast<double>(n) + 1.0) / std::log(2.0);
+}
+
+} // namespace mpn
+
+#endif
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <array>
 #include <algorithm>
 #include <iomanip>
@@ -12,7 +13,39 @@
 #include <type_traits>
 #include <utility>
 #include <compare>
+#include <concepts>
 #include <iterator>
+#include <bit>
+#include <span>
+#include <cstddef>
+#include "mpn.h"
+#include "mpvec.h"
+#include "mparena.h"
+#include "mpmul.h"
+#include "mpdiv.h"
+#include "mpconv.h"
+#include "mpwire.h"
+#include "mpfact.h"
+#include "mppow.h"
+#include "mplazy.h"
+
+template<size_t PRECISION>
+class MPIntBatch;
+
+/*
+ * Co se stane, když se výsledek nevejde do omezené přesnosti:
+ * - Throw: vyhodí se MPInt::OverflowException s oříznutým výsledkem a číslo zůstane beze změny
+ *   (chování operátorů +=, -=, *=, ...).
+ * - Wrap: výsledek se uloží oříznutý a operace jen vrátí true, bez výjimek.
+ * Oříznutí je v obou případech stejné: absolutní hodnota modulo 2^(8 * PRECISION), znaménko zůstává
+ * (čísla jsou ve tvaru znaménko + absolutní hodnota, ne ve dvojkovém doplňku).
+ * Unlimited čísla nikdy nepřetečou.
+ */
+enum class Overflow { Throw, Wrap };
+
+// nativní celé číslo, které se vejde do jednoho limbu (bool se nepočítá)
+template<typename T>
+concept LimbInteger = std::integral<T> && !std::same_as<T, bool> && sizeof(T) <= sizeof(mpn::limb_t);
 
 template<size_t PRECISION>
 class MPInt {
@@ -35,328 +68,351 @@ public:
     // speciální konstanta pro rozlišení Unlimited režimu.
     static constexpr size_t Unlimited = 0;
 
+    // typ jednoho limbu (64bitové slovo) a počet limbů pro Limited režim.
+    // PRECISION stále znamená počet bajtů, poslední limb může být využitý jen částečně.
+    using limb_t = mpn::limb_t;
+    static constexpr size_t LIMBS = (PRECISION + mpn::LIMB_BYTES - 1) / mpn::LIMB_BYTES;
+    // maska platných bitů v nejvyšším limbu Limited čísla
+    static constexpr limb_t TOP_MASK = (PRECISION % mpn::LIMB_BYTES == 0)
+        ? ~limb_t{0}
+        : (limb_t{1} << (8 * (PRECISION % mpn::LIMB_BYTES))) - 1;
+
     // defaultní konstruktor
-    MPInt() {
+    constexpr MPInt() {
         if constexpr (PRECISION == Unlimited) {
             data.resize(0);
         }
-        else {
-            // naplníme array nulama
-            std::fill(data.begin(), data.end(), 0);
-        }
+        // Limited pole se nenuluje, platné jsou jen limby pod used (viz limbCount)
+        zeroForConstant();
     }
 
     // konstrukotr ze stringu, volá přetížený operátor =
-    MPInt(const std::string& str) {
+    constexpr MPInt(std::string_view str) : MPInt() {
         *this = str;
     }
 
-    // kontruktor pro čísla
-    MPInt(const long long num) {
-        // převedem na string a zavoláme přetíženej operátor
-        *this = std::to_string(num);
+    // kontruktor pro nativní čísla - zapíše rovnou limb, bez převodu přes string
+    template<LimbInteger T>
+    constexpr MPInt(const T num) : MPInt() {
+        const limb_t word = wordAbs(num);
+        setData(&word, 1, isNegativeValue(num));
+    }
+
+    // konstruktor z líného výrazu (a + b, a * b + c, ...), výraz se vyhodnotí až tady
+    template<mplazy::LazyExpr E>
+    constexpr MPInt(const E& expr) : MPInt() {
+        assignExpr(expr);
     }
 
     ~MPInt() = default;
 
+    // kopie a přesun stejné přesnosti - u Limited se kopírují jen platné limby, ne celé pole
+    constexpr MPInt(const MPInt& other) : negative(other.negative) {
+        zeroForConstant();
+        copyLimbs(other);
+    }
+    constexpr MPInt(MPInt&& other) noexcept : negative(other.negative) {
+        if constexpr (PRECISION == Unlimited) {
+            data = std::move(other.data);
+        }
+        else {
+            zeroForConstant();
+            copyLimbs(other);
+        }
+    }
+    constexpr MPInt& operator=(const MPInt& other) {
+        if (this != &other) {
+            copyLimbs(other);
+            negative = other.negative;
+        }
+        return *this;
+    }
+    constexpr MPInt& operator=(MPInt&& other) noexcept {
+        if (this != &other) {
+            if constexpr (PRECISION == Unlimited) {
+                data = std::move(other.data);
+            }
+            else {
+                copyLimbs(other);
+            }
+            negative = other.negative;
+        }
+        return *this;
+    }
+
     // copy konstruktor
     template<size_t OTHER_PRECISION>
-    MPInt(const MPInt<OTHER_PRECISION>& other) : MPInt() {
+    constexpr MPInt(const MPInt<OTHER_PRECISION>& other) : MPInt() {
         // když maj stejnou délku není co řešit
         if constexpr (PRECISION == OTHER_PRECISION) {
-            data = other.data; // std::vector nebo std::array assignment
+            copyLimbs(other);
             negative = other.negative;
         }
         else {
             // pokud jsou různé, musíme použít setData - safe funkce pro pokud naplnění dat
-            setData(other.getData(), other.getNegative());
+            setData(other.data.data(), other.limbCount(), other.getNegative());
         }
     }
     // copy assignment
     template<size_t OTHER_PRECISION>
-    MPInt& operator=(const MPInt<OTHER_PRECISION>& other) {
+    constexpr MPInt& operator=(const MPInt<OTHER_PRECISION>& other) {
         // jestli maj stejnou přesnost, neni co řešit
         if constexpr (PRECISION == OTHER_PRECISION) {
             if (this == &other) return *this;
-            data = other.data;
+            copyLimbs(other);
             negative = other.negative;
         }
         else {
             // bezpečnost
-            setData(other.getData(), other.getNegative());
+            setData(other.data.data(), other.limbCount(), other.getNegative());
         }
         return *this;
     }
 
     // move constructor
     template<size_t OTHER_PRECISION>
-    MPInt(MPInt<OTHER_PRECISION>&& other) : MPInt() {
+    constexpr MPInt(MPInt<OTHER_PRECISION>&& other) : MPInt() {
         // stejná přesnost -> neni co řešit
         if constexpr (PRECISION == OTHER_PRECISION) {
-            data = std::move(other.data);
+            if constexpr (PRECISION == Unlimited) data = std::move(other.data);
+            else copyLimbs(other);
             negative = other.negative;
         }
         else {
             // safe cesta
-            setData(other.getData(), other.getNegative());
+            setData(other.data.data(), other.limbCount(), other.getNegative());
         }
         // vynulovat data ostatního
         other.clearData();
     }
     // move assignment
     template<size_t OTHER_PRECISION>
-    MPInt& operator=(MPInt<OTHER_PRECISION>&& other) {
+    constexpr MPInt& operator=(MPInt<OTHER_PRECISION>&& other) {
         if constexpr (PRECISION == OTHER_PRECISION) {
             // ochrana proti move sama sebe
             if (this == &other) return *this;
 
-            data = std::move(other.data);
+            if constexpr (PRECISION == Unlimited) data = std::move(other.data);
+            else copyLimbs(other);
             negative = other.negative;
         }
         else {
-            setData(other.getData(), other.getNegative());
+            setData(other.data.data(), other.limbCount(), other.getNegative());
         }
         other.clearData();
         return *this;
     }
 
-    // naplnění dat za stringu
-    MPInt& operator=(std::string str) {
-        // vymazání mezer
-        str.erase(std::ranges::remove(str, ' ').begin(), str.end());
+    template<mplazy::LazyExpr E>
+    constexpr MPInt& operator=(const E& expr) {
+        assignExpr(expr);
+        return *this;
+    }
+
+    /*
+     * naplnění dat ze stringu
+     * bere std::string_view, takže tokeny a části větších bufferů se nekopírují.
+     * cifry se načítají po 19 (násobení 10^19), dlouhé vstupy rekurzivně (viz mpconv.h).
+     */
+    constexpr MPInt& operator=(std::string_view str) {
+        // vymazání mezer - kopie se dělá jen tehdy, když v řetězci nějaké mezery jsou
+        std::string stripped;
+        if (str.find(' ') != std::string_view::npos) {
+            stripped.assign(str);
+            stripped.erase(std::ranges::remove(stripped, ' ').begin(), stripped.end());
+            str = stripped;
+        }
 
         // ošetření prázdného
         if (str.empty()) {
             throw std::invalid_argument("MPInt argument is empty");
         }
 
-        // vynulovat data, jestli nich předtím bylo něco jiného
-        if constexpr (PRECISION == Unlimited)
-            data.clear();
-        else
-            std::fill(data.begin(), data.end(), 0);
-
         // check - a + na začátku -> přijmeme
-        size_t start_index = 0;
-        negative = false;
+        bool new_negative = false;
         if (str[0] == '-') {
-            negative = true;
-            start_index = 1;
+            new_negative = true;
+            str.remove_prefix(1);
         }
         else if (str[0] == '+') {
-            start_index = 1;
+            str.remove_prefix(1);
         }
 
         // pokud řetězec obsahoval jen - nebo +, je to chyba
-        if (start_index >= str.size()) {
+        if (str.empty()) {
             throw std::invalid_argument("MPInt string contains only sign");
         }
 
-        // projedeme celej string
-        for (size_t k = start_index; k < str.size(); ++k) {
-            const char c = str[k];
-            // musí to být číslo, jinak je to špatně
-            if (c < '0' || c > '9') throw std::invalid_argument("Invalid character in MPInt string");
-            const int digit = c - '0';
+        // projedeme celej string - musí to být čísla, jinak je to špatně
+        if (!std::ranges::all_of(str, [](const char c) { return c >= '0' && c <= '9'; })) {
+            throw std::invalid_argument("Invalid character in MPInt string");
+        }
 
-            int carry = digit;
-            // pokus to narvat do dat
-            for (size_t i = 0; i < data.size(); ++i) {
-                const int val = data[i] * 10 + carry;
-                data[i] = val & 0xFF;
-                carry = val >> 8;
+        const size_t needed = mpn::decimalLimbs(str.size());
+        if constexpr (PRECISION == Unlimited) {
+            // do unlimited se vejde vždy
+            data.resize(needed);
+            data.resize(mpn::fromDecimal(data.data(), str.data(), str.size()));
+        }
+        else {
+            bool overflow;
+            if (needed <= LIMBS) {
+                // běžný případ: načteme rovnou do pole bez alokace
+                used = mpn::fromDecimal(data.data(), str.data(), str.size());
+                overflow = used == LIMBS && data[LIMBS - 1] > TOP_MASK;
             }
-            // pokud zbylo carry
-            if (carry > 0) {
-                // do unlimited prostě přidáme další byte
-                if constexpr (PRECISION == Unlimited)
-                    data.push_back(carry);
-                // jinak to přeteklo
-                else {
-                    // vynulovat
-                    std::fill(data.begin(), data.end(), 0);
-                    throw OverflowException(*this, "Overflow in operator = ");
-                }
+            else {
+                overflow = mpn::withScratch(needed, [&](limb_t* tmp) {
+                    const size_t len = mpn::fromDecimal(tmp, str.data(), str.size());
+                    if (len > LIMBS || (len == LIMBS && tmp[LIMBS - 1] > TOP_MASK)) return true;
+                    std::copy_n(tmp, len, data.begin());
+                    used = len;
+                    return false;
+                });
+            }
+            // jinak to přeteklo
+            if (overflow) {
+                // vynulovat
+                clearData();
+                throw OverflowException(*this, "Overflow in operator = ");
             }
         }
 
-        if (isZero()) {
-            // řešení -0
-            negative = false;
-        }
+        // řešení -0
+        negative = new_negative && !isZero();
         return *this;
     }
 
+    /*
+     * Sčítání a odčítání počítají přímo do *this bez pomocné kopie celého čísla.
+     * Jediná alokace (Unlimited) proběhne před prvním zápisem, Limited součet jde do
+     * pole na zásobníku a zapíše se až po kontrole přetečení -> silná záruka zůstává.
+     */
     template<size_t OTHER_PRECISION>
-    MPInt& operator+=(const MPInt<OTHER_PRECISION>& other) {
-        // pokud jsou stejný znaménka - zavoláme privátní funkci addAbs, která při přetečení
-        // vyhodí overflow -> zachytíme a přidáme msg
-        if (negative == other.getNegative()) {
-            // vytvoříme kopii
-            MPInt<PRECISION> temp = *this;
-
-            try {
-                // pokus o přiřazení
-                temp.addAbs(other);
-                *this = std::move(temp);
-            }
-            catch (const OverflowException& e) {
-                throw OverflowException(e.getResult(), "Overflow in operator +=");
-            }
-        }
-        else {
-            // tady neriskujem overflow
-            if (compareAbs(other) > -1) {
-                subAbs(other);
-            }
-            // tady ale jo
-            else {
-                // vytvoříme s větší přesností
-                MPInt<(PRECISION >= OTHER_PRECISION ? PRECISION : OTHER_PRECISION)> tmp_big;
-                // dáme tam tu větší hodnotu
-                tmp_big = other;
-                // odečteme menší
-                tmp_big.subAbs(*this);
-
-                // pokusíme se to narvat do menší přesnosti, pokud to nepujde -> overflow
-                try {
-                    MPInt<PRECISION> tmp;
-                    tmp.setData(tmp.getData(), !negative);
-                    *this = std::move(tmp);
-                } catch (const OverflowException& e) {
-                    throw OverflowException(e.getResult(), "Overflow in operator +=");;
-                }
-            }
-        }
+    constexpr MPInt& operator+=(const MPInt<OTHER_PRECISION>& other) {
+        add<Overflow::Throw>(other);
         return *this;
     }
 
     template<size_t OTHER_PRECISION>
-    MPInt& operator-=(const MPInt<OTHER_PRECISION>& other) {
-        // stejný znaménka
-        if (negative == other.getNegative()) {
-            // tady neriskujeme overflow
-            if (compareAbs(other) > -1) {
-                subAbs(other);
-            }
-            // tady jo
-            else {
-                // stejně jako v += -> vytvořit ten větší a pak se pokusit to narvat do menšího
-                MPInt<(PRECISION >= OTHER_PRECISION ? PRECISION : OTHER_PRECISION)> tmp_big;
-                tmp_big = other;
-                tmp_big.subAbs(*this);
-
-                try {
-                    MPInt<PRECISION> tmp;
-                    tmp.setData(tmp_big.getData(), !negative);
-                    *this = std::move(tmp);
-                } catch (const OverflowException& e) {
-                    throw OverflowException(e.getResult(), "Overflow in operator -=");
-                }
-            }
-        }
-        else {
-            // pokud se nevejde, zachytíme vyjímku a přidáme msg
-            MPInt<PRECISION> temp = *this;
-            try {
-                temp.addAbs(other);
-                *this = std::move(temp);
-            }
-            catch (const OverflowException& e) {
-                throw OverflowException(e.getResult(), "Overflow in operator -=");
-            }
-        }
+    constexpr MPInt& operator-=(const MPInt<OTHER_PRECISION>& other) {
+        sub<Overflow::Throw>(other);
         return *this;
     }
 
     template<size_t OTHER_PRECISION>
-    MPInt& operator*=(const MPInt<OTHER_PRECISION>& other) {
-        const size_t this_len = data.size();
-        const size_t other_len = other.size();
+    constexpr MPInt& operator*=(const MPInt<OTHER_PRECISION>& other) {
+        mul<Overflow::Throw>(other);
+        return *this;
+    }
+
+    /*
+     * Složené operace s politikou přetečení jako parametrem šablony (viz Overflow):
+     * x.add<Overflow::Wrap>(y) spočítá x += y, při přetečení v x nechá oříznutý výsledek
+     * a vrátí true. S Overflow::Throw jde o totéž co operátory (vrací vždy false).
+     * Dělení a zbytek přetéct nemohou, mají jen operátory.
+     */
+    template<Overflow POLICY, size_t OTHER_PRECISION>
+    constexpr bool add(const MPInt<OTHER_PRECISION>& other) {
+        return addSigned<POLICY>(other, other.getNegative(), "Overflow in operator +=");
+    }
+
+    template<Overflow POLICY, size_t OTHER_PRECISION>
+    constexpr bool sub(const MPInt<OTHER_PRECISION>& other) {
+        return addSigned<POLICY>(other, !other.getNegative(), "Overflow in operator -=");
+    }
+
+    template<Overflow POLICY, size_t OTHER_PRECISION>
+    constexpr bool mul(const MPInt<OTHER_PRECISION>& other) {
+        // počet platných limbů obou čísel
+        const size_t this_len = limbCount();
+        const size_t other_len = other.limbCount();
 
         // pokud je jedno z čísel 0 -> rovnou vrátit 0
-        const bool zeroA = std::all_of(data.begin(), data.end(), [](const uint8_t b){ return b == 0; });
-        const bool zeroB = std::all_of(other.getData().begin(), other.getData().end(), [](uint8_t b){ return b == 0; });
-        if (zeroA || zeroB) {
-            if constexpr (PRECISION == Unlimited) data.clear(); // Pro vektor vyčistíme
-            else std::fill(data.begin(), data.end(), 0);        // Pro array vynulujeme
+        if (this_len == 0 || other_len == 0) {
+            clearData();
+            return false;
+        }
 
-            negative = false;
-            return *this;
+        // x *= x -> umocnění na druhou, každý součin limbů se počítá jen jednou
+        bool same = false;
+        if constexpr (PRECISION == OTHER_PRECISION) {
+            same = this == &other;
         }
 
+        // výpočet výsledného znaménka
+        const bool new_sign = !same && this->negative != other.getNegative();
+
         // maximalní délka je součet délek
-        const size_t result_len = this_len + other_len;
-        // použití vektoru pro dočasný výsledek
-        std::vector<uint8_t> result(result_len, 0);
-
-        // algoritmus školního násobení
-        // iterace přes obě čísla byte po bytu
-        for (size_t i = 0; i < this_len; ++i) {
-            uint16_t carry = 0;
-            for (size_t j = 0; j < other_len; ++j) {
-                // pozice ve výsledku je součet indexů i + j.
-                const size_t pos = i + j;
-                // výpočet: (číslice A * číslice B) + (hodnota co už tam je) + přenos
-                const uint16_t multiply = static_cast<uint16_t>(data[i])
-                                        * static_cast<uint16_t>(other.data[j])
-                                        + result[pos] + carry;
-
-                // uložení posledních 8 bitů
-                result[pos] = static_cast<uint8_t>(multiply & 0xFF);
-
-                // horních 8 do carry
-                carry = multiply >> 8;
+        // dočasný výsledek v odkládací aréně (dovoluje i x *= x)
+        const size_t size = this_len + other_len;
+        return mpn::withScratch(size, [&](limb_t* result) {
+            // násobící engine sám zvolí školní násobení, Karatsubu nebo Toom-3 (viz mpmul.h)
+            if (same)
+                mpn::sqr(result, data.data(), this_len);
+            else if (this_len >= other_len)
+                mpn::mul(result, data.data(), this_len, other.data.data(), other_len);
+            else
+                mpn::mul(result, other.data.data(), other_len, data.data(), this_len);
+
+            if constexpr (PRECISION == Unlimited) {
+                // odstranění přebytečných nul na konci (v Little Endian jsou to nuly nejvyššího řádu)
+                const size_t len = mpn::normalize(result, size);
+                // resize zvětšuje kapacitu geometricky, opakované x *= y tedy alokuje jen občas
+                data.resize(len);
+                std::copy_n(result, len, data.begin());
+                negative = new_sign;
+                return false;
             }
-            // pokud po dokončení řádku zbyl přenos, přičteme ho k vyššímu řádu
-            if (carry > 0) {
-                const size_t pos = i + other_len;
-                if (pos < result.size())
-                    result[pos] += static_cast<uint8_t>(carry);
-                else
-                    result.push_back(static_cast<uint8_t>(carry));
+            else {
+                return commit<POLICY>(result, size, new_sign, "Overflow in operator *=");
             }
-        }
+        });
+    }
 
-        // výpočet výsledného znaménka
-        bool new_sign = this->negative != other.getNegative();
+    /*
+     * Druhá mocnina čísla. Symetrické součiny a_i * a_j se počítají jednou a zdvojí,
+     * stejná úspora platí i uvnitř Karatsuby, Toom-3 a NTT (viz mpn::sqr).
+     */
+    constexpr MPInt<PRECISION> square() const {
+        const size_t len = limbCount();
+        MPInt<PRECISION> result;
+        if (len == 0) return result;
 
+        mpn::withScratch(2 * len, [&](limb_t* product) {
+            mpn::sqr(product, data.data(), len);
+            return result.template commit<Overflow::Throw>(product, 2 * len, false, "Overflow in square");
+        });
+        return result;
+    }
 
-        if constexpr (PRECISION == Unlimited) {
-            // odstranění přebytečných nul na konci (v Little Endian jsou to nuly nejvyššího řádu)
-            while (!result.empty() && result.back() == 0) {
-                result.pop_back();
-            }
-            data = std::move(result);
-            negative = new_sign;
-        }
-        else {
-            // kontrola přetečení
-            MPInt<PRECISION> temp;
-            temp.negative = new_sign;
+    /*
+     * Složené operátory s líným výrazem: x += a * b se spočítá jedním průchodem
+     * (viz mplazy.h), výsledek se do *this zapíše až po úspěšném vyhodnocení.
+     */
+    template<mplazy::LazyExpr E>
+    constexpr MPInt& operator+=(const E& expr) {
+        return *this = *this + expr;
+    }
 
-            bool overflow = false;
+    template<mplazy::LazyExpr E>
+    constexpr MPInt& operator-=(const E& expr) {
+        return *this = *this - expr;
+    }
 
-            for (size_t i = 0; i < result.size(); i++) {
-                uint8_t byte = result[i];
+    template<mplazy::LazyExpr E>
+    constexpr MPInt& operator*=(const E& expr) {
+        return *this *= expr.eval();
+    }
 
-                if (i < temp.data.size()) {
-                    temp.data[i] = byte;
-                }
-                else if (byte != 0) {
-                    overflow = true;
-                }
-            }
+    template<mplazy::LazyExpr E>
+    MPInt& operator/=(const E& expr) {
+        return *this /= expr.eval();
+    }
 
-            if (overflow) {
-                // vyhodíme výjimku obsahující 'temp' (oříznutý výsledek).
-                // původní objekt *this je stále v původním stavu.
-                throw OverflowException(temp, "Overflow in operator *=");
-            }
-            // commit změn pouze pokud nenastala chyba
-            *this = std::move(temp);
-        }
-        return *this;
+    template<mplazy::LazyExpr E>
+    MPInt& operator%=(const E& expr) {
+        return *this %= expr.eval();
     }
 
     template<size_t OTHER_PRECISION>
@@ -365,8 +421,8 @@ public:
         const bool new_sign = negative != other.getNegative();
         // uděláme změny
         absDiv(other);
-        // uložíme nové znaménko
-        negative = new_sign;
+        // uložíme nové znaménko (nula je vždy kladná)
+        negative = new_sign && !isZero();
         return *this;
     }
 
@@ -377,271 +433,678 @@ public:
         return *this;
     }
 
-    template<size_t OTHER_PRECISION>
-    int compareAbs(const MPInt<OTHER_PRECISION>& other) const {
-        const size_t this_len = data.size();
-        const size_t other_len = other.size();
-        const size_t max_len = std::max(this_len, other_len);
-
-        for (int i = static_cast<int>(max_len) - 1; i >= 0; --i) {
-            const uint8_t this_byte = (i < this_len) ? data[i] : 0;
-            const uint8_t other_byte = (i < other_len) ? other.data[i] : 0;
-            // jakmile je ten byte větší - víme že je to číslo větší
-            if (this_byte > other_byte)
-                return 1;
-            if (this_byte < other_byte)
-                return -1;
-        }
-
-        // sem projedou stejý čísla
-        return 0;
+    /*
+     * Operace s nativním číslem (int64_t, uint64_t, ...) bez stavby pomocného MPInt.
+     * Každá proběhne jedním průchodem přes limby (mpn::add/sub, mul_1, divrem_1).
+     */
+    template<LimbInteger T>
+    constexpr MPInt& operator+=(const T value) {
+        add<Overflow::Throw>(value);
+        return *this;
     }
 
-    MPInt<PRECISION> factorial() const {
-        // sanity check
-        if (negative) {
-            throw std::invalid_argument("MPInt factorial of negative number is undefined.");
-        }
-        if (isZero()) {
-            MPInt<PRECISION> result;
-            result = "1";
-            return result;
-        }
-        // pomocné mpinty
-        MPInt<1> one("1");
-        MPInt<PRECISION> result;
-        result = "1";
-        MPInt<PRECISION> counter;
-        counter = "2";
-
-        while (counter <= *this) {
-            try {
-                // pokus o násobení
-                result *= counter;
-            } catch (const OverflowException& e) {
-                // vyhození vyjímky
-                throw OverflowException(e.getResult(), "MPInt overflow in factorial");
-            }
-            counter += one;
-        }
-
-        return result;
+    template<LimbInteger T>
+    constexpr MPInt& operator-=(const T value) {
+        sub<Overflow::Throw>(value);
+        return *this;
     }
 
-    // pro výpis pomocí streamu
-    friend std::ostream& operator<<(std::ostream& os, const MPInt<PRECISION>& num) {
-        os << num.toString();
-        return os;
+    template<LimbInteger T>
+    constexpr MPInt& operator*=(const T value) {
+        mul<Overflow::Throw>(value);
+        return *this;
     }
 
-    std::string toString() const {
-        if (data.empty() || std::all_of(data.begin(), data.end(), [](const uint8_t b){ return b == 0; }))
-            return "0";
-
-        // pracujeme na kopii, protože algoritmus je destruktivní
-        MPInt<PRECISION> temp;
-        temp = *this;
-        const MPInt<1> ten("10");
-        std::string digits;
-
-        // zbytek po dělení 10 (temp % 10) je poslední číslice (jednotky).
-        // číslo vydělíme 10 (temp /= 10) a posuneme se o řád níž.
-        // ppakujeme, dokud není číslo nula.
-        while (!temp.isZero()) {
-            MPInt<PRECISION> remainder = temp.absDiv(ten); // temp /= 10, remainder = temp % 10
-            digits.push_back('0' + remainder.getDataOnPos(0)); // převod na znak
-        }
-
-        std::ranges::reverse(digits); // cifry byly od nejnižší po nejvyšší
-
-        // přidat -
-        if (negative)
-            digits.insert(digits.begin(), '-');
-
-        return digits;
+    template<Overflow POLICY, LimbInteger T>
+    constexpr bool add(const T value) {
+        return addWord<POLICY>(wordAbs(value), isNegativeValue(value), "Overflow in operator +=");
     }
 
-    // gettery
-    size_t size() const {
-        return data.size();
-    }
-    uint8_t getDataOnPos(size_t index) const {
-        if (index >= data.size()) {
-            return 0;
-        }
-        return data[index];
-    }
-    const auto& getData() const {
-        return data;
-    }
-    bool getUnlimited() const {
-        return PRECISION == Unlimited;
+    template<Overflow POLICY, LimbInteger T>
+    constexpr bool sub(const T value) {
+        return addWord<POLICY>(wordAbs(value), !isNegativeValue(value), "Overflow in operator -=");
     }
-    bool getNegative() const {
-        return negative;
+
+    template<Overflow POLICY, LimbInteger T>
+    constexpr bool mul(const T value) {
+        return mulWord<POLICY>(wordAbs(value), isNegativeValue(value));
     }
 
+    template<LimbInteger T>
+    constexpr MPInt& operator/=(const T value) {
+        divRem(value);
+        return *this;
+    }
 
-private:
-    bool negative = false; // true = záporné číslo
+    template<LimbInteger T>
+    constexpr MPInt& operator%=(const T value) {
+        const bool sign = negative;
+        const limb_t remainder = divRemWord(wordAbs(value));
+        // zbytek je menší než původní číslo, takže se vždy vejde
+        setData(&remainder, 1, sign);
+        return *this;
+    }
 
     /*
-     * Uložiště dat:
-     * - Používáme Little Endian (nejméně významný bajt je na indexu 0).
-     * - To zjednodušuje matematické operace (sčítání, násobení), protože se iteruje od 0.
-     * - Hybridní model paměti:
-     * - Pokud je PRECISION == 0 (Unlimited), používáme std::vector (dynamická paměť na haldě).
-     * - Pokud je PRECISION > 0 (Limited), používáme std::array (statická paměť na zásobníku).
-     * - std::conditional_t vybírá typ v době kompilace.
+     * Vydělí číslo nativním dělitelem (jako /=) a vrátí absolutní hodnotu zbytku.
+     * Zbytek má znaménko původního dělence, stejně jako u operátoru %.
      */
-    using DataContainer = std::conditional_t<
-        PRECISION == Unlimited,
-        std::vector<uint8_t>,           // pro Unlimited je to Vector
-        std::array<uint8_t, PRECISION>  // pro Limited je to Array
-    >;
+    template<LimbInteger T>
+    constexpr limb_t divRem(const T divisor) {
+        const bool new_sign = negative != isNegativeValue(divisor);
+        const limb_t remainder = divRemWord(wordAbs(divisor));
+        negative = new_sign && !isZero();
+        return remainder;
+    }
 
-    DataContainer data;
+    // změna znaménka na místě (nula zůstává kladná)
+    constexpr MPInt& negate() {
+        negative = !negative && !isZero();
+        return *this;
+    }
+
+    // opačné číslo (hlavně pro záporné literály: -5_mp)
+    constexpr MPInt operator-() const {
+        MPInt result = *this;
+        result.negate();
+        return result;
+    }
 
-    // aby instance MPInt s jinou přesnostínmohla přistupovat
-    // k privátním členům  této instance
     template<size_t OTHER_PRECISION>
-    friend class MPInt;
+    constexpr int compareAbs(const MPInt<OTHER_PRECISION>& other) const {
+        // porovnání od nejvyššího limbu, jakmile je limb větší - víme že je to číslo větší
+        return mpn::cmp(data.data(), limbCount(), other.data.data(), other.limbCount());
+    }
 
     /*
-     * univerzální metoda pro bezpečné nastavení dat.
-     * přijímá jakýkoliv kontejner díky šabloně.
+     * Faktoriál vyváženým stromem součinů nad nativními čísly (viz mpfact.h).
+     * threads určuje počet vláken pro podstromy, 0 = podle hardwaru.
+     * Pro omezenou přesnost se přetečení pozná předem z odhadu log-gamma,
+     * takže se obrovský faktoriál vůbec nepočítá.
      */
-    template <typename ContainerType>
-    void setData(const ContainerType& other, const bool other_negative) {
-        // pokud je tento objekt Unlimited (std::vector), nemůže dojít k přetečení
-        if constexpr (PRECISION == Unlimited) {
-            data.clear();
-            data.assign(other.begin(), other.end());
-            negative = other_negative;
-            return;
+    MPInt<PRECISION> factorial(unsigned threads = 0) const {
+        // sanity check
+        if (negative) {
+            throw std::invalid_argument("MPInt factorial of negative number is undefined.");
         }
 
-        // vyčistíme data
-        std::fill(data.begin(), data.end(), 0);
-
-        bool overflow = false;
-        // pokus o narvání čísla
-        for (size_t i = 0; i < other.size(); i++) {
-            uint8_t byte = other[i]; // funguje pro vector i array
-            if (byte == 0) {
-                continue;
+        const size_t len = limbCount();
+        MPInt<PRECISION> result;
+        if (len > 1) {
+            // n >= 2^64, n! je dělitelné 2^(n - 64) - oříznutý výsledek je nula
+            if constexpr (PRECISION != Unlimited) {
+                throw OverflowException(result, "MPInt overflow in factorial");
             }
-            // nemůžem se vejít
-            if (i >= data.size()) {
-                overflow = true;
+            throw std::invalid_argument("MPInt factorial argument is too large.");
+        }
+        const std::uint64_t n = len == 0 ? 0 : data[0];
+
+        if constexpr (PRECISION != Unlimited) {
+            // n! má aspoň n - popcount(n) dvojek, pokud jich je víc než bitů, oříznutý výsledek je nula
+            // a není co počítat; jinak je n malé a přesný výpočet je levný
+            const double bits = mpn::factorialBits(n);
+            if (bits > 8.0 * PRECISION + 1 && n - std::popcount(n) >= 8 * PRECISION) {
+                throw OverflowException(result, "MPInt overflow in factorial");
+            }
+        }
+
+        try {
+            if (n <= 20) {
+                // 20! < 2^64 se vejde do jednoho limbu, strom součinů není potřeba
+                limb_t word = 1;
+                for (std::uint64_t i = 2; i <= n; ++i) word *= i;
+                result.setData(&word, 1, false);
             }
             else {
-                data[i] = byte;
+                const std::vector<limb_t> value = mpn::factorial(n, threads);
+                result.setData(value.data(), value.size(), false);
             }
-
+        } catch (const OverflowException& e) {
+            // vyhození vyjímky
+            throw OverflowException(e.getResult(), "MPInt overflow in factorial");
         }
-        negative = other_negative;
+        return result;
+    }
 
-        // pokud sme se nevešli, vrátíme přetečení
-        if (overflow) {
-            throw OverflowException(*this);
-        }
+    /*
+     * Mocnina s nativním exponentem posuvným oknem (viz mppow.h), 0^0 = 1.
+     * Pro omezenou přesnost se z počtu bitů základu odhadne, jestli výsledek určitě přeteče;
+     * v tom případě se počítá jen modulo B^LIMBS, jinak přesně na nejvýše dvojnásobné délce.
+     */
+    MPInt<PRECISION> pow(const std::uint64_t exp) const {
+        MPInt<PRECISION> result;
+        powInto<Overflow::Throw>(result, exp);
+        return result;
     }
 
-    // vyčištění
-    void clearData() {
-        negative = false;
+    // result = this^exp s politikou přetečení POLICY, vrací true při přetečení (jen Wrap)
+    template<Overflow POLICY>
+    bool powInto(MPInt<PRECISION>& result, const std::uint64_t exp) const {
+        const size_t len = limbCount();
+        const bool sign = negative && (exp & 1);
+        if (exp == 0) {
+            const limb_t one = 1;
+            result.setData(&one, 1, false);
+            return false;
+        }
+        if (len == 0) {
+            result.clearData();
+            return false;
+        }
+
         if constexpr (PRECISION == Unlimited) {
-            data.clear();
+            result.data = mpn::pow<DataContainer>(data.data(), len, exp);
+            result.negative = sign;
+            return false;
         }
         else {
-            std::ranges::fill(data, 0);
+            // base^exp má aspoň exp * (bits - 1) + 1 a nejvýše exp * bits bitů
+            const size_t bits = mpn::pow_detail::bitLength(data.data(), len);
+            const bool overflow = bits > 1 && exp >= (8 * PRECISION + bits - 2) / (bits - 1);
+            const std::vector<limb_t> value = mpn::pow(data.data(), len, exp, overflow ? LIMBS : 2 * LIMBS);
+            const bool wrapped = result.template commit<POLICY>(value.data(), value.size(), sign, "Overflow in pow");
+            // při jistém přetečení se počítalo jen modulo B^LIMBS, oříznutý výsledek je ale správný
+            if constexpr (POLICY == Overflow::Throw) {
+                if (overflow) {
+                    throw OverflowException(result, "Overflow in pow");
+                }
+            }
+            return wrapped || overflow;
         }
     }
 
+    // mocnina s exponentem v MPInt, exponent se musí vejít do jednoho limbu
     template<size_t OTHER_PRECISION>
-    void addAbs(const MPInt<OTHER_PRECISION>& other) {
-        uint16_t carry = 0;
-        const size_t this_len = data.size();
-        const size_t other_len = other.size();
-
-        // zjistíme maximální délku, abychom prošli všechny řády obou čísel
-        const size_t max_len = std::max(this_len, other_len);
-
-        bool overflow = false;
+    MPInt<PRECISION> pow(const MPInt<OTHER_PRECISION>& exp) const {
+        if (exp.getNegative()) {
+            throw std::invalid_argument("MPInt negative exponent is not supported.");
+        }
+        const size_t exp_len = exp.limbCount();
+        if (exp_len > 1) {
+            throw std::invalid_argument("MPInt exponent is too large.");
+        }
+        return pow(exp_len == 0 ? std::uint64_t{0} : exp.data[0]);
+    }
 
-        for (size_t i = 0; i < max_len; ++i) {
-            // bezpečné načtení bajtů: pokud je index mimo rozsah kratšího čísla, bereme 0
-            const uint16_t this_byte = (i < this_len) ? data[i] : 0;
-            const uint16_t other_byte = (i < other_len) ? other.data[i] : 0;
+    // exponent z líného výrazu se nejdřív vyhodnotí
+    template<mplazy::LazyExpr E>
+    MPInt<PRECISION> pow(const E& exp) const {
+        return pow(exp.eval());
+    }
 
-            // samotný součet bajtů včetně přenosu z minula
-            const uint16_t sum = this_byte + other_byte + carry;
+    /*
+     * Modulární mocnina this^exp mod |mod|, výsledek je vždy v [0, |mod|).
+     * Lichý modul používá Montgomeryho násobení, sudý Barrettovu redukci (viz mppow.h).
+     * Výsledek má přesnost základu, u Limited se do ní větší modul nemusí vejít.
+     */
+    template<size_t EXP_PRECISION, size_t MOD_PRECISION>
+    MPInt<PRECISION> powmod(const MPInt<EXP_PRECISION>& exp, const MPInt<MOD_PRECISION>& mod) const {
+        // sanity check
+        if (mod.isZero()) {
+            throw std::invalid_argument("MPInt division by zero");
+        }
+        if (exp.getNegative()) {
+            throw std::invalid_argument("MPInt negative exponent is not supported.");
+        }
 
-            if constexpr (PRECISION != Unlimited) {
-                if (i < data.size()) {
-                    // jsme uvnitř pole, můžeme zapisovat
-                    data[i] = static_cast<uint8_t>(sum & 0xFF);
-                }
-                else if (sum != 0) {
-                    // jsme mimo pole A zároveň máme nenulovou hodnotu -> chyba
-                    overflow = true;
-                }
-            }
-            // unlimited prostě zvětšíme
-            else {
-                if (i >= data.size()) data.push_back(static_cast<uint8_t>(sum & 0xFF));
-                else data[i] = static_cast<uint8_t>(sum & 0xFF);
-            }
+        const limb_t* m = mod.data.data();
+        const size_t n = mod.limbCount();
+        const size_t exp_len = exp.limbCount();
 
-            // bitový posun pro získání přenosu do další iterace
-            carry = sum >> 8;
+        // základ zredukovaný do [0, |mod|)
+        mpn::ScratchBuffer base(n);
+        mpn::pow_detail::modReduce(base.data(), data.data(), limbCount(), m, n);
+        if (negative && mpn::normalize(base.data(), n) > 0) {
+            mpn::sub(base.data(), m, n, base.data(), n);
         }
 
-        // zpracování zbylého přenosu po ukončení cyklu
-        if (carry != 0) {
-            if constexpr (PRECISION != Unlimited)
-                overflow = true;
-            else {
-                data.push_back(static_cast<uint8_t>(carry));
-            }
+        mpn::ScratchBuffer value(n, 0);
+        if (exp_len == 0) {
+            // x^0 = 1, modulo 1 je to ale nula
+            const limb_t one = 1;
+            mpn::pow_detail::modReduce(value.data(), &one, 1, m, n);
         }
-
-        if (overflow) {
-            throw OverflowException(*this);
+        else {
+            mpn::powm(value.data(), base.data(), n, exp.data.data(), exp_len, m, n);
         }
-    }
 
-    template<size_t OTHER_PRECISION>
-    // funkce předpokládá, že |this| >= |other|
-    void subAbs(const MPInt<OTHER_PRECISION>& other) {
-        int16_t borrow = 0;
-        const size_t this_len = data.size();
-        const size_t other_len = other.size();
-
-       // algoritmus odčítání pod sebou (Little Endian).
-       // procházíme od nejnižšího řádu k nejvyššímu.
-        for (size_t i = 0; i < this_len; ++i) {
-            const int16_t this_byte = data[i];
-            // pokud je druhé číslo kratší, doplníme virtuální nuly
-            const int16_t other_byte = (i < other_len) ? other.getDataOnPos(i) : 0;
-
-            // výpočet rozdílu včetně předchozí výpůjčky
-            int16_t diff = this_byte - other_byte - borrow;
-
-            // řešení podtečení v rámci bajtu
-            if (diff < 0) {
-                // půjčíme si 256 z vyššího řádu
-                diff += 256;
-                // nastavíme dluh pro další iteraci
-                borrow = 1;
-            }
-            else {
-                borrow = 0;
-            }
+        MPInt<PRECISION> result;
+        result.template commit<Overflow::Throw>(value.data(), value.size(), false, "Overflow in powmod");
+        return result;
+    }
 
-            data[i] = static_cast<uint8_t>(diff & 0xFF);
-        }
+    // exponent nebo modul z líného výrazu (a.powmod(e, m * 2)), výraz se nejdřív vyhodnotí
+    template<mplazy::Operand E, mplazy::Operand M>
+        requires (mplazy::LazyExpr<E> || mplazy::LazyExpr<M>)
+    MPInt<PRECISION> powmod(const E& exp, const M& mod) const {
+        return powmod(mplazy::value(exp), mplazy::value(mod));
+    }
+
+    // pro výpis pomocí streamu
+    friend std::ostream& operator<<(std::ostream& os, const MPInt<PRECISION>& num) {
+        os << num.toString();
+        return os;
+    }
+
+    std::string toString() const {
+        std::string digits;
+        toString(digits);
+        return digits;
+    }
+
+    /*
+     * Desítkový zápis do bufferu volajícího (původní obsah se přepíše).
+     * Malá čísla se převádějí po 19 cifrách jen na zásobníku, takže pokud má buffer
+     * dostatečnou kapacitu, nedojde k žádné alokaci. Velká čísla se dělí rekurzivně
+     * mocninami deseti (viz mpconv.h).
+     */
+    void toString(std::string& out) const {
+        out.clear();
+        const size_t len = limbCount();
+        // 64 bitů je nejvýše 20 cifer, plus znaménko
+        out.reserve(len * 20 + 2);
+
+        // přidat -
+        if (negative && len > 0)
+            out.push_back('-');
+        mpn::toDecimal(out, data.data(), len);
+    }
+
+    std::string toHex() const {
+        std::string digits;
+        toHex(digits);
+        return digits;
+    }
+
+    // šestnáctkový zápis (malá písmena, bez předpony 0x) do bufferu volajícího, lineární čas
+    void toHex(std::string& out) const {
+        out.clear();
+        const size_t len = limbCount();
+        out.reserve(len * 16 + 1);
+        if (negative && len > 0)
+            out.push_back('-');
+        mpn::toHex(out, data.data(), len);
+    }
+
+    /*
+     * číslo ze šestnáctkového zápisu: volitelné znaménko, volitelná předpona 0x/0X,
+     * cifry 0-9, a-f, A-F. Chyby a přetečení se hlásí stejně jako u desítkového řetězce.
+     */
+    static constexpr MPInt fromHex(std::string_view str) {
+        if (str.empty()) {
+            throw std::invalid_argument("MPInt argument is empty");
+        }
+
+        bool new_negative = false;
+        if (str[0] == '-' || str[0] == '+') {
+            new_negative = str[0] == '-';
+            str.remove_prefix(1);
+        }
+        if (str.size() >= 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+            str.remove_prefix(2);
+        }
+        if (str.empty()) {
+            throw std::invalid_argument("MPInt string contains only sign");
+        }
+        if (!std::ranges::all_of(str, [](const char c) { return mpn::hexDigit(c) >= 0; })) {
+            throw std::invalid_argument("Invalid character in MPInt hex string");
+        }
+
+        // úvodní nuly se přeskočí, pak počet cifer přesně určuje počet limbů
+        str.remove_prefix(std::min(str.find_first_not_of('0'), str.size()));
+        const size_t needed = mpn::hexLimbs(str.size());
+
+        MPInt result;
+        if constexpr (PRECISION == Unlimited) {
+            result.data.resize(needed);
+            mpn::fromHex(result.data.data(), str.data(), str.size());
+        }
+        else {
+            bool overflow = needed > LIMBS;
+            if (!overflow) {
+                result.used = mpn::fromHex(result.data.data(), str.data(), str.size());
+                overflow = result.used == LIMBS && result.data[LIMBS - 1] > TOP_MASK;
+            }
+            if (overflow) {
+                throw OverflowException(MPInt(), "Overflow in fromHex");
+            }
+        }
+        result.negative = new_negative && !result.isZero();
+        return result;
+    }
+
+    // velikost binárního zápisu v bajtech (hlavička a platné limby, viz mpwire.h)
+    constexpr size_t serializedSize() const {
+        return mpn::wire::encodedSize(limbCount());
+    }
+
+    // binární zápis na začátek out (aspoň serializedSize() bajtů), vrací počet zapsaných bajtů
+    size_t serialize(std::span<std::byte> out) const {
+        const size_t len = limbCount();
+        if (out.size() < mpn::wire::encodedSize(len)) {
+            throw std::invalid_argument("MPInt serialize buffer is too small");
+        }
+        return mpn::wire::encode(out.data(), data.data(), len, negative);
+    }
+
+    /*
+     * číslo z binárního zápisu na začátku in (spotřebuje serializedSize() bajtů výsledku).
+     * Limby se kopírují přímo do výsledku, čtení bez kopie nabízí MPIntView.
+     * Limited při přetečení vyhodí OverflowException s oříznutým číslem jako aritmetika.
+     */
+    static MPInt deserialize(std::span<const std::byte> in) {
+        const mpn::wire::Header header = mpn::wire::decodeHeader(in);
+        MPInt result;
+        if constexpr (PRECISION == Unlimited) {
+            result.data.resize(header.len);
+            mpn::wire::decodeLimbs(result.data.data(), in, header.len);
+            result.negative = header.negative;
+        }
+        else {
+            // oříznutí jako v assignWrapped, jen se limby načtou rovnou na místo
+            bool overflow = header.len > LIMBS;
+            mpn::wire::decodeLimbs(result.data.data(), in, std::min(header.len, LIMBS));
+            // po oříznutí můžou nahoře zůstat nuly, délka se vždy normalizuje
+            result.used = mpn::normalize(result.data.data(), std::min(header.len, LIMBS));
+            if (result.used == LIMBS && result.data[LIMBS - 1] > TOP_MASK) {
+                result.data[LIMBS - 1] &= TOP_MASK;
+                result.used = mpn::normalize(result.data.data(), LIMBS);
+                overflow = true;
+            }
+            result.negative = header.negative && result.used > 0;
+            if (overflow) {
+                throw OverflowException(result, "Overflow in deserialize");
+            }
+        }
+        return result;
+    }
+
+    // gettery
+    // velikost v bajtech (u Limited je to PRECISION, u Unlimited počet platných bajtů)
+    constexpr size_t size() const {
+        if constexpr (PRECISION == Unlimited) {
+            const size_t len = data.size();
+            if (len == 0) return 0;
+            return (len - 1) * mpn::LIMB_BYTES + (mpn::LIMB_BYTES - std::countl_zero(data[len - 1]) / 8);
+        }
+        else {
+            return PRECISION;
+        }
+    }
+    // bajt na pozici index (Little Endian), limby jsou interně 64bitové
+    constexpr uint8_t getDataOnPos(size_t index) const {
+        const size_t limb = index / mpn::LIMB_BYTES;
+        if (limb >= limbCount()) {
+            return 0;
+        }
+        return static_cast<uint8_t>(data[limb] >> (8 * (index % mpn::LIMB_BYTES)));
+    }
+    // bajtová podoba dat (std::vector pro Unlimited, std::array<uint8_t, PRECISION> pro Limited)
+    auto getData() const {
+        if constexpr (PRECISION == Unlimited) {
+            std::vector<uint8_t> bytes(size());
+            for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = getDataOnPos(i);
+            return bytes;
+        }
+        else {
+            std::array<uint8_t, PRECISION> bytes{};
+            for (size_t i = 0; i < PRECISION; ++i) bytes[i] = getDataOnPos(i);
+            return bytes;
+        }
+    }
+    constexpr bool getUnlimited() const {
+        return PRECISION == Unlimited;
+    }
+    constexpr bool getNegative() const {
+        return negative;
+    }
+
+
+private:
+    bool negative = false; // true = záporné číslo
+
+    /*
+     * Uložiště dat:
+     * - Data jsou v 64bitových limbech, mezivýsledky se počítají ve 128 bitech (viz mpn.h).
+     * - Používáme Little Endian (nejméně významný limb je na indexu 0).
+     * - To zjednodušuje matematické operace (sčítání, násobení), protože se iteruje od 0.
+     * - Hybridní model paměti:
+     * - Pokud je PRECISION == 0 (Unlimited), používáme mpn::LimbVector (malé hodnoty uvnitř
+     *   objektu, větší na haldě, viz mpvec.h). Haldu lze nahradit vlastním
+     *   std::pmr::memory_resource přes mpn::LimbResourceScope.
+     * - Mezivýsledky výpočtů (součiny, podíly, převody) leží v odkládací aréně vlákna (mparena.h).
+     * - Pokud je PRECISION > 0 (Limited), používáme std::array (statická paměť na zásobníku).
+     * - std::conditional_t vybírá typ v době kompilace.
+     * - Unlimited vektor je vždy normalizovaný (žádné nulové limby nahoře, nula = prázdný vektor).
+     * - Limited pole má v posledním limbu nastavené jen bity pod hranicí PRECISION (TOP_MASK).
+     */
+    using DataContainer = std::conditional_t<
+        PRECISION == Unlimited,
+        mpn::LimbVector,                // pro Unlimited je to Vector s vnitřním bufferem
+        std::array<limb_t, LIMBS>       // pro Limited je to Array
+    >;
+
+    DataContainer data;
+
+    /*
+     * Počet platných limbů Limited čísla: data[used - 1] je nenulový a limby nad used
+     * nemají definovanou hodnotu, takže se nikdy nečtou. Všechny operace pracují jen
+     * s platným rozsahem, malé číslo ve velké přesnosti je tak stejně levné jako v malé.
+     * Unlimited délku nese přímo (normalizovaný) vektor.
+     */
+    struct NoLength {};
+    [[no_unique_address]] std::conditional_t<PRECISION == Unlimited, NoLength, size_t> used{};
+
+    // aby instance MPInt s jinou přesnostínmohla přistupovat
+    // k privátním členům  této instance
+    template<size_t OTHER_PRECISION>
+    friend class MPInt;
+
+    // líné výrazy čtou limby přímo a Unlimited výsledek převezmou bez kopie
+    friend struct mplazy::Access;
+
+    // dávka čísel (mpbatch.h) převádí limby do sloupců a zpět bez mezikopií
+    template<size_t BATCH_PRECISION>
+    friend class MPIntBatch;
+
+    // vyhodnocení líného výrazu do *this (při chybě zůstane *this beze změny)
+    template<mplazy::LazyExpr E>
+    constexpr void assignExpr(const E& expr) {
+        if constexpr (E::terms == 1 && !E::products) {
+            // jediný člen (MPIntView): limby rovnou do *this, Unlimited využije svou paměť
+            const mplazy::Term t = mplazy::singleTerm(expr);
+            commit<Overflow::Throw>(t.limbs, t.len, t.negative, "Overflow in MPInt expression");
+        }
+        else if constexpr (E::precision != Unlimited && (PRECISION == Unlimited || PRECISION > E::precision)) {
+            // výraz s omezenou přesností se musí vejít do své přesnosti, stejně jako dřív a + b
+            *this = MPInt<E::precision>(expr);
+        }
+        else {
+            MPInt<PRECISION> result;
+            mplazy::evaluate(result, expr);
+            *this = std::move(result);
+        }
+    }
+
+    // počet platných limbů (nejvyšší je nenulový, nula má 0 limbů)
+    constexpr size_t limbCount() const {
+        if constexpr (PRECISION == Unlimited) {
+            return data.size();
+        }
+        else {
+            // used <= LIMBS platí vždy, min jen dává překladači horní mez (jinak u převodu
+            // do Unlimited varuje před čtením za koncem pole v nedosažitelné větvi)
+            return std::min(used, LIMBS);
+        }
+    }
+
+    // hodnota vzniklá při překladu (constexpr) musí mít inicializované celé pole, za běhu se nenuluje
+    constexpr void zeroForConstant() {
+        if constexpr (PRECISION != Unlimited) {
+            if (std::is_constant_evaluated()) data.fill(0);
+        }
+    }
+
+    // převzetí limbů čísla stejné přesnosti
+    constexpr void copyLimbs(const MPInt& other) {
+        if constexpr (PRECISION == Unlimited) {
+            data = other.data;
+        }
+        else {
+            std::copy_n(other.data.begin(), other.used, data.begin());
+            used = other.used;
+        }
+    }
+
+    /*
+     * univerzální metoda pro bezpečné nastavení dat.
+     * přijímá libovolné pole limbů (vector i array) jako ukazatel a délku.
+     */
+    constexpr void setData(const limb_t* other, size_t other_len, const bool other_negative) {
+        // pokud sme se nevešli, vrátíme přetečení (s už oříznutým číslem)
+        if (assignWrapped(other, other_len, other_negative)) {
+            throw OverflowException(*this);
+        }
+    }
+
+    // nastavení dat oříznutých na naši přesnost, vrací true, pokud se číslo nevešlo (nevyhazuje)
+    constexpr bool assignWrapped(const limb_t* other, size_t other_len, const bool other_negative) {
+        other_len = mpn::normalize(other, other_len);
+
+        // pokud je tento objekt Unlimited (LimbVector), nemůže dojít k přetečení
+        if constexpr (PRECISION == Unlimited) {
+            data.assign(other, other + other_len);
+            negative = other_negative && other_len > 0;
+            return false;
+        }
+        else {
+            // pokus o narvání čísla - nemůžem se vejít, pokud je něco nad LIMBS nebo nad TOP_MASK
+            bool overflow = other_len > LIMBS;
+            std::copy_n(other, std::min(other_len, LIMBS), data.begin());
+            // oříznutá hodnota může mít nahoře nuly (i celá být nula), délka se vždy normalizuje
+            used = mpn::normalize(data.data(), std::min(other_len, LIMBS));
+            if (used == LIMBS && data[LIMBS - 1] > TOP_MASK) {
+                data[LIMBS - 1] &= TOP_MASK;
+                used = mpn::normalize(data.data(), LIMBS);
+                overflow = true;
+            }
+            negative = other_negative && used > 0;
+            return overflow;
+        }
+    }
+
+    /*
+     * Zápis výsledku spočítaného bokem podle politiky přetečení:
+     * Throw při přetečení nechá *this beze změny a vyhodí výjimku s oříznutým výsledkem,
+     * Wrap oříznutý výsledek uloží a vrátí true.
+     */
+    template<Overflow POLICY>
+    constexpr bool commit(const limb_t* value, const size_t len, const bool sign, const char* msg) {
+        if constexpr (POLICY == Overflow::Wrap || PRECISION == Unlimited) {
+            return assignWrapped(value, len, sign);
+        }
+        else {
+            MPInt<PRECISION> temp;
+            if (temp.assignWrapped(value, len, sign)) {
+                throw OverflowException(temp, msg);
+            }
+            // commit změn pouze pokud nenastala chyba
+            *this = std::move(temp);
+            return false;
+        }
+    }
+
+    // vyčištění
+    constexpr void clearData() {
+        negative = false;
+        if constexpr (PRECISION == Unlimited) {
+            data.clear();
+        }
+        else {
+            used = 0;
+        }
+    }
+
+    // this += (other_negative ? -|other| : |other|), vrací true při přetečení (jen Wrap)
+    template<Overflow POLICY, size_t OTHER_PRECISION>
+    constexpr bool addSigned(const MPInt<OTHER_PRECISION>& other, const bool other_negative, const char* msg) {
+        // stejná znaménka - sčítáme absolutní hodnoty, tady hrozí přetečení
+        if (negative == other_negative) {
+            return addAbs<POLICY>(other, msg);
+        }
+        // tady neriskujem overflow
+        else if (compareAbs(other) > -1) {
+            subAbs(other);
+            return false;
+        }
+        // |other| - |this| se nemusí vejít do naší přesnosti
+        else {
+            return reverseSubAbs<POLICY>(other, msg);
+        }
+    }
+
+    // |this| += |other|, při přetečení zůstane *this beze změny (Throw) nebo oříznuté (Wrap)
+    template<Overflow POLICY, size_t OTHER_PRECISION>
+    constexpr bool addAbs(const MPInt<OTHER_PRECISION>& other, const char* msg) {
+        const size_t other_len = other.limbCount();
+
+        if constexpr (PRECISION == Unlimited) {
+            // místo pro případný přenos se rezervuje předem, po prvním zápisu už se nealokuje
+            const size_t len = std::max(data.size(), other_len);
+            data.reserve(len + 1);
+            data.resize(len, 0);
+            const limb_t carry = mpn::add(data.data(), data.data(), len, other.data.data(), other_len);
+            if (carry != 0) data.push_back(carry);
+            return false;
+        }
+        else {
+            // limby druhého čísla nad naší délkou znamenají jisté přetečení,
+            // do výsledku (oříznutého) se ale nepromítnou
+            const size_t fit_len = std::min(other_len, LIMBS);
+            // mpn::add chce delší operand jako první, r smí být kterýkoli z nich
+            const bool longer = used >= fit_len;
+            const limb_t* a = longer ? data.data() : other.data.data();
+            const limb_t* b = longer ? other.data.data() : data.data();
+            const size_t len = longer ? used : fit_len;
+            const size_t b_len = longer ? fit_len : used;
+
+            if (len < LIMBS) {
+                // přenos (nejvýše 1) padne do limbu nad len a do TOP_MASK se vejde vždy
+                const limb_t carry = mpn::add(data.data(), a, len, b, b_len);
+                data[len] = carry;
+                used = len + (carry != 0);
+                return false;
+            }
+
+            std::array<limb_t, LIMBS> sum;
+            const limb_t carry = mpn::add(sum.data(), a, LIMBS, b, b_len);
+
+            if (carry != 0 || other_len > LIMBS || sum[LIMBS - 1] > TOP_MASK) {
+                // jsme mimo povolené bity -> oříznutý výsledek (assignWrapped ořízne nejvyšší limb)
+                if constexpr (POLICY == Overflow::Wrap) {
+                    assignWrapped(sum.data(), LIMBS, negative);
+                    return true;
+                }
+                else {
+                    MPInt<PRECISION> truncated;
+                    truncated.assignWrapped(sum.data(), LIMBS, negative);
+                    throw OverflowException(truncated, msg);
+                }
+            }
+            data = sum;
+            used = LIMBS;
+            return false;
+        }
+    }
+
+    template<size_t OTHER_PRECISION>
+    // funkce předpokládá, že |this| >= |other|
+    constexpr void subAbs(const MPInt<OTHER_PRECISION>& other) {
+        // |other| <= |this|, takže platné limby druhého čísla se vejdou do našich
+        const size_t other_len = other.limbCount();
+
+        // algoritmus odčítání pod sebou (Little Endian), viz mpn::sub
+        mpn::sub(data.data(), data.data(), limbCount(), other.data.data(), other_len);
 
         // Normalizace pro Unlimited: Odstranění nul na začátku čísla
         if constexpr (PRECISION == Unlimited) {
@@ -649,6 +1112,47 @@ private:
                 data.pop_back();
             }
         }
+        else {
+            used = mpn::normalize(data.data(), used);
+        }
+        if (isZero()) negative = false;
+    }
+
+    /*
+     * this = |other| - |this| se znaménkem !negative (volá se pro |this| < |other|).
+     * Pokud se |other| vejde do naší přesnosti, vejde se i rozdíl a počítá se na místě.
+     * Jinak se výsledek počítá bokem a zapíše se podle politiky přetečení (viz commit).
+     */
+    template<Overflow POLICY, size_t OTHER_PRECISION>
+    constexpr bool reverseSubAbs(const MPInt<OTHER_PRECISION>& other, const char* msg) {
+        const size_t this_len = limbCount();
+        const size_t other_len = other.limbCount();
+
+        bool fits = true;
+        if constexpr (PRECISION != Unlimited) {
+            fits = other_len < LIMBS || (other_len == LIMBS && other.data[LIMBS - 1] <= TOP_MASK);
+        }
+
+        if (fits) {
+            if constexpr (PRECISION == Unlimited) {
+                data.resize(other_len, 0);
+            }
+            // limby nad this_len se jen zapisují, čte se jen platný rozsah (mpn::sub dovoluje r == b)
+            mpn::sub(data.data(), other.data.data(), other_len, data.data(), this_len);
+            if constexpr (PRECISION == Unlimited) {
+                data.resize(mpn::normalize(data.data(), other_len));
+            }
+            else {
+                used = mpn::normalize(data.data(), other_len);
+            }
+            negative = !negative;
+            return false;
+        }
+
+        return mpn::withScratch(other_len, [&](limb_t* diff) {
+            mpn::sub(diff, other.data.data(), other_len, data.data(), this_len);
+            return commit<POLICY>(diff, other_len, !negative, msg);
+        });
     }
 
     template<size_t OTHER_PRECISION>
@@ -667,72 +1171,183 @@ private:
             return remainder;
         }
 
-        std::vector<uint8_t> result_data(data.size(), 0);   // pole pro podíl
-        std::vector<uint8_t> remainder_data;                    // buffer pro aktuální zbyte
+        const size_t this_len = limbCount();
+        const size_t other_len = other.limbCount();
 
-        MPInt<PRECISION> current_rem;   // pomocný objekt pro výpočty se zbytkem
+        mpn::ScratchBuffer result_data(this_len - other_len + 1);   // pole pro podíl
+        mpn::ScratchBuffer remainder_data(other_len);               // pole pro zbytek
 
-        bool leading_zeros_flag = true;
-        // algoritmus písemného dělení
-        // iterujeme od nejvýznamnějšího bajtu k nejméně významnému.
-        for (size_t i = data.size(); i > 0; --i) {
-            size_t idx = i - 1;
+        if (other_len == 1) {
+            // rychlá cesta pro jednolimbový dělitel
+            remainder_data[0] = mpn::divrem_1(result_data.data(), data.data(), this_len, other.data[0]);
+        }
+        else {
+            // Knuthův algoritmus D (viz mpdiv.h)
+            mpn::divrem(result_data.data(), remainder_data.data(), data.data(), this_len,
+                        other.data.data(), other_len);
+        }
 
-            // Přeskočení úvodních nul dělence
-            if (data[idx] == 0 && leading_zeros_flag) {
-                continue;
-            }
-            leading_zeros_flag = false;
-            // sepíšeme další číslici: přidáme bajt na nejnižší pozici aktuálního zbytku
-            remainder_data.insert(remainder_data.begin(), data[idx]);
-
-            // úklid bufferu (odstranění nepotřebných nul)
-            while (remainder_data.size() > 1 && remainder_data.back() == 0)
-                remainder_data.pop_back();
-
-            current_rem.setData(remainder_data, false);
-
-            // hledání cifry podílu
-            // kolikrát se dělitel vejde do aktuálního zbytku?
-            uint8_t q = 0;
-            while (current_rem.compareAbs(other) > -1) {    // dokud je zbytek >= dělitel
-                current_rem.subAbs(other);
-                q++;
-            }
+        // příprava návratové hodnoty - zbytku
+        MPInt<PRECISION> remainder;
+        remainder.setData(remainder_data.data(), remainder_data.size(), negative);
+        this->setData(result_data.data(), result_data.size(), negative);
+        return remainder;
+    }
 
-            result_data[idx] = q;
+    // pomocná fce na určení 0
+    constexpr bool isZero() const {
+        return limbCount() == 0;
+    }
 
-            // aktualizace zbytku pro další iteraci
-            const auto& rem_d = current_rem.getData();
-            remainder_data.assign(rem_d.begin(), rem_d.end());
+    // absolutní hodnota nativního čísla jako limb (funguje i pro INT64_MIN)
+    template<LimbInteger T>
+    static constexpr limb_t wordAbs(const T value) {
+        if constexpr (std::is_signed_v<T>) {
+            return value < 0 ? limb_t{0} - static_cast<limb_t>(value) : static_cast<limb_t>(value);
+        }
+        else {
+            return static_cast<limb_t>(value);
+        }
+    }
+
+    template<LimbInteger T>
+    static constexpr bool isNegativeValue(const T value) {
+        if constexpr (std::is_signed_v<T>) {
+            return value < 0;
+        }
+        else {
+            return false;
+        }
+    }
+
+    // this += (w_negative ? -w : w), vrací true při přetečení (jen Wrap)
+    template<Overflow POLICY>
+    constexpr bool addWord(const limb_t w, const bool w_negative, const char* msg) {
+        if (w == 0) return false;
+        const size_t len = limbCount();
+
+        if (len == 0 || negative == w_negative) {
+            // stejná znaménka (nebo nula) - sčítáme absolutní hodnoty
+            return addAbsWord<POLICY>(w, len == 0 ? w_negative : negative, msg);
+        }
+        else if (len > 1 || data[0] >= w) {
+            // |this| >= w, přetečení nehrozí
+            mpn::sub(data.data(), data.data(), len, &w, 1);
+            if constexpr (PRECISION == Unlimited) {
+                data.resize(mpn::normalize(data.data(), len));
+            }
+            else {
+                used = mpn::normalize(data.data(), len);
+            }
+            negative = negative && !isZero();
+            return false;
         }
+        else {
+            // |this| < w, výsledek w - |this| má znaménko w a u Limited se nemusí vejít
+            const limb_t diff = w - data[0];
+            return commit<POLICY>(&diff, 1, w_negative, msg);
+        }
+    }
 
+    // |this| += w a nastaví znaménko sign, při přetečení zůstane *this beze změny (Throw) nebo oříznuté (Wrap)
+    template<Overflow POLICY>
+    constexpr bool addAbsWord(const limb_t w, const bool sign, const char* msg) {
         if constexpr (PRECISION == Unlimited) {
-            while (!result_data.empty() && result_data.back() == 0) {
-                result_data.pop_back();
+            if (data.empty()) {
+                data.push_back(w);
+            }
+            else {
+                const limb_t carry = mpn::add(data.data(), data.data(), data.size(), &w, 1);
+                if (carry != 0) data.push_back(carry);
+            }
+        }
+        else {
+            const size_t len = used;
+            limb_t carry = len == 0 ? w : mpn::add(data.data(), data.data(), len, &w, 1);
+            size_t new_len = len;
+            if (carry != 0 && len < LIMBS) {
+                data[new_len++] = carry;
+                carry = 0;
+            }
+            if (carry != 0 || (new_len == LIMBS && data[LIMBS - 1] > TOP_MASK)) {
+                // všech LIMBS limbů je zapsaných, součet modulo B^LIMBS stačí oříznout
+                if constexpr (POLICY == Overflow::Wrap) {
+                    data[LIMBS - 1] &= TOP_MASK;
+                    used = mpn::normalize(data.data(), LIMBS);
+                    negative = sign && used > 0;
+                    return true;
+                }
+                // oříznutý výsledek do výjimky, původní hodnotu vrátí odečtení (počítá se modulo B^len)
+                MPInt<PRECISION> truncated;
+                std::copy_n(data.begin(), LIMBS, truncated.data.begin());
+                truncated.data[LIMBS - 1] &= TOP_MASK;
+                truncated.used = mpn::normalize(truncated.data.data(), LIMBS);
+                truncated.negative = sign && !truncated.isZero();
+                if (len > 0) mpn::sub(data.data(), data.data(), len, &w, 1);
+                throw OverflowException(truncated, msg);
             }
+            used = new_len;
         }
+        negative = sign;
+        return false;
+    }
 
-        // příprava návratové hodnoty - zbytku
-        MPInt<PRECISION> remainder;
-        remainder.setData(remainder_data, negative);
-        this->setData(result_data, negative);
-        return remainder;
+    // this *= (w_negative ? -w : w), vrací true při přetečení (jen Wrap)
+    template<Overflow POLICY>
+    constexpr bool mulWord(const limb_t w, const bool w_negative) {
+        const size_t len = limbCount();
+        if (w == 0 || len == 0) {
+            clearData();
+            return false;
+        }
+        const bool new_sign = negative != w_negative;
+
+        if constexpr (PRECISION == Unlimited) {
+            const limb_t carry = mpn::mul_1(data.data(), data.data(), len, w);
+            if (carry != 0) data.push_back(carry);
+            negative = new_sign;
+            return false;
+        }
+        else if (len + 1 < LIMBS) {
+            // horní limb součinu padne pod nejvyšší limb přesnosti, přetečení nehrozí
+            const limb_t carry = mpn::mul_1(data.data(), data.data(), len, w);
+            data[len] = carry;
+            used = len + (carry != 0);
+            negative = new_sign;
+            return false;
+        }
+        else {
+            // součin bokem i s horním limbem, zapíše se podle politiky přetečení
+            std::array<limb_t, LIMBS + 1> product;
+            product[len] = mpn::mul_1(product.data(), data.data(), len, w);
+            return commit<POLICY>(product.data(), len + 1, new_sign, "Overflow in operator *=");
+        }
     }
 
-    // pomocná fce na určení 0
-    bool isZero() const {
-        return std::all_of(data.begin(), data.end(), [](uint8_t b) {
-            return b == 0;
-        });
+    // |this| /= w, vrací zbytek (znaménko neřeší)
+    constexpr limb_t divRemWord(const limb_t w) {
+        if (w == 0) {
+            throw std::invalid_argument("MPInt division by zero");
+        }
+        const size_t len = limbCount();
+        if (len == 0) return 0;
+
+        const limb_t remainder = mpn::divrem_1(data.data(), data.data(), len, w);
+        if constexpr (PRECISION == Unlimited) {
+            data.resize(mpn::normalize(data.data(), len));
+        }
+        else {
+            used = mpn::normalize(data.data(), len);
+        }
+        return remainder;
     }
 };
 
 /*
  * -----------------------------------------------------------------------------
- * Globální aritmetické operátory (+, -, *, /, %)
+ * Globální aritmetické operátory (/, %)
  * -----------------------------------------------------------------------------
- * Všechny operátory fungují na stejném principu:
+ * Operátory +, - a * vytvářejí líné výrazy (viz mplazy.h), dělení a zbytek se počítají hned:
  * 1. Jsou šablonované, aby umožnily operace mezi různými přesnostmi (PREC_A, PREC_B).
  * 2. Návratový typ 'auto' se určí podle pravidel:
  * - Pokud je alespoň jeden operand Unlimited -> výsledek je Unlimited.
@@ -741,84 +1356,210 @@ private:
  * 4. Implementace využívá již hotové operátory +=, -=, atd.
  */
 template <size_t PREC_A, size_t PREC_B>
-auto operator+(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
+auto operator/(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
     constexpr bool anyUnlimited = (PREC_A == MPInt<PREC_A>::Unlimited || PREC_B == MPInt<PREC_B>::Unlimited);
     if constexpr (anyUnlimited) {
         MPInt<MPInt<PREC_A>::Unlimited> result = a;
-        result += b;
+        result /= b;
         return result;
     }
     else {
         constexpr size_t MaxBytes = (PREC_A > PREC_B ? PREC_A : PREC_B);
         MPInt<MaxBytes> result = a;
-        result += b;
+        result /= b;
         return result;
     }
 }
 
 template <size_t PREC_A, size_t PREC_B>
-auto operator-(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
+auto operator%(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
     constexpr bool anyUnlimited = (PREC_A == MPInt<PREC_A>::Unlimited || PREC_B == MPInt<PREC_B>::Unlimited);
     if constexpr (anyUnlimited) {
         MPInt<MPInt<PREC_A>::Unlimited> result = a;
-        result -= b;
+        result %= b;
         return result;
     }
     else {
         constexpr size_t MaxBytes = (PREC_A > PREC_B ? PREC_A : PREC_B);
         MPInt<MaxBytes> result = a;
-        result -= b;
+        result %= b;
         return result;
     }
 }
 
-template <size_t PREC_A, size_t PREC_B>
-auto operator*(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
-    constexpr bool anyUnlimited = (PREC_A == MPInt<PREC_A>::Unlimited || PREC_B == MPInt<PREC_B>::Unlimited);
-    if constexpr (anyUnlimited) {
-        MPInt<MPInt<PREC_A>::Unlimited> result = a;
-        result *= b;
-        return result;
+/*
+ * Operátory s nativním číslem vpravo (a + 5, a * 10, ...).
+ * Výsledek má přesnost MPInt operandu, počítá se jedním průchodem přes limby.
+ */
+template <size_t PREC, LimbInteger T>
+constexpr MPInt<PREC> operator+(const MPInt<PREC>& a, const T b) {
+    MPInt<PREC> result = a;
+    result += b;
+    return result;
+}
+
+template <size_t PREC, LimbInteger T>
+constexpr MPInt<PREC> operator-(const MPInt<PREC>& a, const T b) {
+    MPInt<PREC> result = a;
+    result -= b;
+    return result;
+}
+
+template <size_t PREC, LimbInteger T>
+constexpr MPInt<PREC> operator*(const MPInt<PREC>& a, const T b) {
+    MPInt<PREC> result = a;
+    result *= b;
+    return result;
+}
+
+template <size_t PREC, LimbInteger T>
+constexpr MPInt<PREC> operator/(const MPInt<PREC>& a, const T b) {
+    MPInt<PREC> result = a;
+    result /= b;
+    return result;
+}
+
+template <size_t PREC, LimbInteger T>
+constexpr MPInt<PREC> operator%(const MPInt<PREC>& a, const T b) {
+    MPInt<PREC> result = a;
+    result %= b;
+    return result;
+}
+
+// volné varianty mocnin, volají metody MPInt::pow a MPInt::powmod
+template <size_t PREC>
+MPInt<PREC> pow(const MPInt<PREC>& base, const std::uint64_t exp) {
+    return base.pow(exp);
+}
+
+template <size_t PREC, size_t PREC_EXP, size_t PREC_MOD>
+MPInt<PREC> powmod(const MPInt<PREC>& base, const MPInt<PREC_EXP>& exp, const MPInt<PREC_MOD>& mod) {
+    return base.powmod(exp, mod);
+}
+
+// varianty pro líné výrazy (pow(x + y, 2), powmod(a, e, m * 2)), operandy se nejdřív vyhodnotí
+template <mplazy::LazyExpr E>
+auto pow(const E& base, const std::uint64_t exp) {
+    return base.eval().pow(exp);
+}
+
+template <mplazy::Operand B, mplazy::Operand E, mplazy::Operand M>
+    requires (mplazy::LazyExpr<B> || mplazy::LazyExpr<E> || mplazy::LazyExpr<M>)
+auto powmod(const B& base, const E& exp, const M& mod) {
+    return mplazy::value(base).powmod(mplazy::value(exp), mplazy::value(mod));
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ * Aritmetika bez výjimek (checkedAdd, checkedSub, checkedMul, checkedPow)
+ * -----------------------------------------------------------------------------
+ * Vrací výsledek v přesnosti levého operandu (jako a += b) a příznak přetečení.
+ * Přetečený výsledek je oříznutý stejně jako v MPInt::OverflowException (viz Overflow::Wrap).
+ * Pravý operand může být MPInt libovolné přesnosti nebo nativní číslo.
+ */
+template <size_t PREC>
+struct Checked {
+    MPInt<PREC> value;
+    bool overflow = false;
+};
+
+template <size_t PREC, typename T>
+constexpr Checked<PREC> checkedAdd(const MPInt<PREC>& a, const T& b) {
+    Checked<PREC> result{a};
+    result.overflow = result.value.template add<Overflow::Wrap>(b);
+    return result;
+}
+
+template <size_t PREC, typename T>
+constexpr Checked<PREC> checkedSub(const MPInt<PREC>& a, const T& b) {
+    Checked<PREC> result{a};
+    result.overflow = result.value.template sub<Overflow::Wrap>(b);
+    return result;
+}
+
+template <size_t PREC, typename T>
+constexpr Checked<PREC> checkedMul(const MPInt<PREC>& a, const T& b) {
+    Checked<PREC> result{a};
+    result.overflow = result.value.template mul<Overflow::Wrap>(b);
+    return result;
+}
+
+template <size_t PREC>
+Checked<PREC> checkedPow(const MPInt<PREC>& base, const std::uint64_t exp) {
+    Checked<PREC> result;
+    result.overflow = base.template powInto<Overflow::Wrap>(result.value, exp);
+    return result;
+}
+
+/*
+ * -----------------------------------------------------------------------------
+ * Čtení binárního zápisu bez kopírování (MPIntView)
+ * -----------------------------------------------------------------------------
+ * View drží jen ukazatel na limby v bufferu, jejich počet a znaménko (formát viz mpwire.h).
+ * Buffer musí žít déle než view a limby v něm musí být zarovnané na 8 bajtů.
+ * Je to list líného výrazu s neomezenou přesností, takže MPInt<P> x = view, x += view,
+ * view + a - b nebo view < a čtou limby rovnou z bufferu (součin a dělení si view
+ * nejdřív převedou na MPInt<0>, stejně jako ostatní výrazy).
+ */
+class MPIntView : public mplazy::Node {
+public:
+    static constexpr size_t precision = 0;
+    static constexpr size_t terms = 1;
+    static constexpr bool products = false;
+
+    MPIntView() = default;
+
+    // view na číslo na začátku in, další číslo začíná za serializedSize() bajty
+    static MPIntView deserialize(std::span<const std::byte> in) {
+        const mpn::wire::Header header = mpn::wire::decodeHeader(in);
+        return MPIntView(mpn::wire::viewLimbs(in), header.len, header.negative);
     }
-    else {
-        constexpr size_t MaxBytes = (PREC_A > PREC_B ? PREC_A : PREC_B);
-        MPInt<MaxBytes> result = a;
-        result *= b;
-        return result;
+
+    std::span<const mpn::limb_t> limbs() const {
+        return {data, len};
+    }
+    size_t serializedSize() const {
+        return mpn::wire::encodedSize(len);
+    }
+    bool getNegative() const {
+        return negative;
+    }
+    bool isZero() const {
+        return len == 0;
     }
-}
 
-template <size_t PREC_A, size_t PREC_B>
-auto operator/(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
-    constexpr bool anyUnlimited = (PREC_A == MPInt<PREC_A>::Unlimited || PREC_B == MPInt<PREC_B>::Unlimited);
-    if constexpr (anyUnlimited) {
-        MPInt<MPInt<PREC_A>::Unlimited> result = a;
-        result /= b;
-        return result;
+    std::string toString() const {
+        std::string out;
+        if (negative) out.push_back('-');
+        mpn::toDecimal(out, data, len);
+        return out;
     }
-    else {
-        constexpr size_t MaxBytes = (PREC_A > PREC_B ? PREC_A : PREC_B);
-        MPInt<MaxBytes> result = a;
-        result /= b;
-        return result;
+    std::string toHex() const {
+        std::string out;
+        if (negative) out.push_back('-');
+        mpn::toHex(out, data, len);
+        return out;
     }
-}
 
-template <size_t PREC_A, size_t PREC_B>
-auto operator%(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
-    constexpr bool anyUnlimited = (PREC_A == MPInt<PREC_A>::Unlimited || PREC_B == MPInt<PREC_B>::Unlimited);
-    if constexpr (anyUnlimited) {
-        MPInt<MPInt<PREC_A>::Unlimited> result = a;
-        result %= b;
-        return result;
+    template<typename Collector>
+    constexpr void collect(bool negate, Collector& out) const {
+        out.term({data, len, negative != negate});
     }
-    else {
-        constexpr size_t MaxBytes = (PREC_A > PREC_B ? PREC_A : PREC_B);
-        MPInt<MaxBytes> result = a;
-        result %= b;
+
+    MPInt<0> eval() const {
+        MPInt<0> result;
+        mplazy::evaluate(result, *this);
         return result;
     }
-}
+    operator MPInt<0>() const { return eval(); }
+
+private:
+    const mpn::limb_t* data = nullptr;
+    size_t len = 0;
+    bool negative = false;
+
+    MPIntView(const mpn::limb_t* data, size_t len, bool negative) : data(data), len(len), negative(negative) {}
+};
 
 /*
  * -----------------------------------------------------------------------------
@@ -826,18 +1567,18 @@ auto operator%(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
  * -----------------------------------------------------------------------------
  */
 template <size_t PREC_A, size_t PREC_B>
-bool operator==(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
+constexpr bool operator==(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
     if (a.getNegative() != b.getNegative()) return false;
     return a.compareAbs(b) == 0;
 }
 
 template <size_t PREC_A, size_t PREC_B>
-bool operator!=(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
+constexpr bool operator!=(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
     return !(a == b);
 }
 
 template <size_t PREC_A, size_t PREC_B>
-bool operator<(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
+constexpr bool operator<(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
     if (a.getNegative() && !b.getNegative()) return true;
     if (!a.getNegative() && b.getNegative()) return false;
     const int cmp = a.compareAbs(b);
@@ -845,17 +1586,61 @@ bool operator<(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
 }
 
 template <size_t PREC_A, size_t PREC_B>
-bool operator>(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
+constexpr bool operator>(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
     return b < a;
 }
 
 template <size_t PREC_A, size_t PREC_B>
-bool operator<=(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
+constexpr bool operator<=(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
     return !(a > b);
 }
 
 template <size_t PREC_A, size_t PREC_B>
-bool operator>=(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
+constexpr bool operator>=(const MPInt<PREC_A>& a, const MPInt<PREC_B>& b) {
     return !(a < b);
 }
-#endif
\ No newline at end of file
+
+/*
+ * -----------------------------------------------------------------------------
+ * Literál _mp (123_mp, 1'000'000_mp, -42_mp)
+ * -----------------------------------------------------------------------------
+ * Cifry se načtou při překladu (consteval) do nejmenší přesnosti po celých limbech,
+ * do které se číslo vejde (MPInt<8>, MPInt<16>, ...). Větší přesnost dá přiřazení
+ * nebo výraz: constexpr MPInt<32> x = 2_mp * 12345678901234567890_mp;
+ * Přijímá jen desítkové cifry a oddělovače ', úvodní nula neznamená osmičkovou soustavu.
+ */
+namespace mpliteral {
+
+template<char... CHARS>
+struct Digits {
+    static constexpr bool valid = ((CHARS == '\'' || (CHARS >= '0' && CHARS <= '9')) && ...);
+    static constexpr size_t count = ((CHARS != '\'' ? 1 : 0) + ...);
+
+    // cifry bez oddělovačů
+    static constexpr std::array<char, count> value = [] {
+        std::array<char, count> out{};
+        size_t i = 0;
+        for (const char c : {CHARS...}) {
+            if (c != '\'') out[i++] = c;
+        }
+        return out;
+    }();
+
+    // přesnost v bajtech: počet limbů hodnoty, aspoň jeden
+    static constexpr size_t precision = [] {
+        std::array<mpn::limb_t, mpn::decimalLimbs(count)> limbs{};
+        const size_t len = mpn::fromDecimal(limbs.data(), value.data(), count);
+        return std::max<size_t>(len, 1) * mpn::LIMB_BYTES;
+    }();
+};
+
+} // namespace mpliteral
+
+template<char... CHARS>
+consteval auto operator""_mp() {
+    using D = mpliteral::Digits<CHARS...>;
+    static_assert(D::valid, "_mp accepts only decimal digits");
+    return MPInt<D::precision>(std::string_view(D::value.data(), D::count));
+}
+
+#endif
@@ -0,0 +1,536 @@
+#ifndef SEM_2_MPLAZY_H
+#define SEM_2_MPLAZY_H
+
+#include <vector>
+#include <array>
+#include <string>
+#include <ostream>
+#include <algorithm>
+#include <concepts>
+#include <type_traits>
+#include "mpn.h"
+#include "mparena.h"
+#include "mpvec.h"
+#include "mpmul.h"
+
+/*
+ * Líné výrazy (expression templates) pro +, - a * nad MPInt.
+ * - a + b, a - b a a * b nevrací hotové MPInt, ale malý objekt popisující výraz.
+ *   Výpočet proběhne až při přiřazení do konkrétního MPInt<P> (nebo při porovnání, výpisu).
+ * - Celý řetězec sčítání a odčítání (a + b + c - d) se sečte jedním průchodem přes limby:
+ *   kladné a záporné členy zvlášť do dvou akumulátorů, na konci jedno odečtení.
+ * - Součin v řetězci (a * b + c) se spočítá rovnou do akumulátoru a ostatní členy
+ *   se k němu přičtou ve stejném průchodu (násobení s akumulací bez mezivýsledku).
+ * - Omezená přesnost má akumulátory na zásobníku, další součiny v řetězci (a * b + c * d)
+ *   jdou do odkládací arény vlákna (mparena.h), přetečení se kontroluje až u výsledku.
+ * - Výraz drží operandy MPInt referencí, takže nesmí přežít proměnné, ze kterých vznikl
+ *   (auto x = a + b je v pořádku jen dokud žijí a i b).
+ * Dělení a zbytek zůstávají přímé, líný operand se před nimi vyhodnotí.
+ * Výrazy nad omezenou přesností jde vyhodnotit i při překladu (constexpr).
+ * Hlavička se vkládá na začátku mpint.h, MPInt je tu jen deklarované.
+ */
+
+template<size_t PRECISION>
+class MPInt;
+
+namespace mplazy {
+
+using mpn::limb_t;
+
+// společný předek všech uzlů výrazu
+struct Node {};
+
+template<typename T>
+concept LazyExpr = std::derived_from<T, Node>;
+
+/*
+ * Metody MPInt dostupné i na výrazu, aby (a + b).toString() nebo (x * y).pow(3) fungovaly
+ * jako dřív, když operátory vracely hotové MPInt. Výraz se vyhodnotí a zavolá se metoda výsledku.
+ */
+template<typename Derived>
+struct Evaluated {
+    std::string toString() const { return self().eval().toString(); }
+    void toString(std::string& out) const { self().eval().toString(out); }
+    std::string toHex() const { return self().eval().toHex(); }
+    constexpr bool getNegative() const { return self().eval().getNegative(); }
+    auto factorial(unsigned threads = 0) const { return self().eval().factorial(threads); }
+
+    template<typename E>
+    auto pow(const E& exp) const { return self().eval().pow(exp); }
+
+    template<typename E, typename M>
+    auto powmod(const E& exp, const M& mod) const { return self().eval().powmod(exp, mod); }
+
+private:
+    constexpr const Derived& self() const { return static_cast<const Derived&>(*this); }
+};
+
+template<typename T>
+struct IsMPInt : std::false_type {};
+template<size_t P>
+struct IsMPInt<MPInt<P>> : std::true_type {};
+
+template<typename T>
+concept Value = IsMPInt<T>::value;
+
+template<typename T>
+concept Operand = Value<T> || LazyExpr<T>;
+
+// přesnost výsledku podle pravidel globálních operátorů (Unlimited vyhrává, jinak větší)
+constexpr size_t combinePrecision(size_t a, size_t b) {
+    return (a == 0 || b == 0) ? 0 : std::max(a, b);
+}
+
+template<typename T>
+struct Traits;
+
+template<size_t P>
+struct Traits<MPInt<P>> {
+    static constexpr size_t precision = P;
+    static constexpr size_t terms = 1;
+    static constexpr bool products = false;
+    using Stored = const MPInt<P>&;   // list se drží referencí
+};
+
+template<LazyExpr T>
+struct Traits<T> {
+    static constexpr size_t precision = T::precision;
+    static constexpr size_t terms = T::terms;
+    static constexpr bool products = T::products;
+    using Stored = T;                 // uzly jsou malé a drží se hodnotou
+};
+
+// jeden člen součtu: pole limbů se znaménkem
+struct Term {
+    const limb_t* limbs;
+    size_t len;
+    bool negative;
+};
+
+// součin dvou čísel v součtu
+struct ProductTerm {
+    const limb_t* a;
+    size_t a_len;
+    const limb_t* b;
+    size_t b_len;
+    bool negative;
+};
+
+/*
+ * Přístup k vnitřnostem MPInt (MPInt ho má jako friend).
+ */
+struct Access {
+    template<size_t P>
+    static constexpr Term term(const MPInt<P>& x, bool negate) {
+        return {x.data.data(), x.limbCount(), x.negative != negate};
+    }
+
+    // výsledek z pole limbů, u Limited při přetečení vyhodí OverflowException s oříznutým výsledkem
+    template<size_t P>
+    static constexpr void assign(MPInt<P>& x, const limb_t* r, size_t n, bool negative) {
+        try {
+            x.setData(r, n, negative);
+        } catch (const typename MPInt<P>::OverflowException& e) {
+            throw typename MPInt<P>::OverflowException(e.getResult(), "Overflow in MPInt expression");
+        }
+    }
+
+    // Unlimited výsledek převezme buffer bez kopírování
+    template<size_t P>
+        requires (P == 0)
+    static void adopt(MPInt<P>& x, mpn::LimbVector&& r, bool negative) {
+        r.resize(mpn::normalize(r.data(), r.size()));
+        x.negative = negative && !r.empty();
+        x.data = std::move(r);
+    }
+};
+
+template<size_t P, LazyExpr E>
+constexpr void evaluate(MPInt<P>& result, const E& expr);
+
+template<size_t P, typename Collector>
+constexpr void collectOperand(const MPInt<P>& x, bool negate, Collector& out) {
+    out.term(Access::term(x, negate));
+}
+
+template<LazyExpr E, typename Collector>
+constexpr void collectOperand(const E& e, bool negate, Collector& out) {
+    e.collect(negate, out);
+}
+
+/*
+ * Součet nebo rozdíl dvou operandů (SUB = true znamená left - right).
+ */
+template<Operand L, Operand R, bool SUB>
+struct Sum : Node, Evaluated<Sum<L, R, SUB>> {
+    static constexpr size_t precision = combinePrecision(Traits<L>::precision, Traits<R>::precision);
+    static constexpr size_t terms = Traits<L>::terms + Traits<R>::terms;
+    static constexpr bool products = Traits<L>::products || Traits<R>::products;
+
+    typename Traits<L>::Stored left;
+    typename Traits<R>::Stored right;
+
+    constexpr Sum(const L& l, const R& r) : left(l), right(r) {}
+
+    template<typename Collector>
+    constexpr void collect(bool negate, Collector& out) const {
+        collectOperand(left, negate, out);
+        collectOperand(right, negate != SUB, out);
+    }
+
+    constexpr MPInt<precision> eval() const {
+        MPInt<precision> result;
+        evaluate(result, *this);
+        return result;
+    }
+    constexpr operator MPInt<precision>() const { return eval(); }
+};
+
+/*
+ * Součin dvou MPInt.
+ */
+template<size_t PA, size_t PB>
+struct Product : Node, Evaluated<Product<PA, PB>> {
+    static constexpr size_t precision = combinePrecision(PA, PB);
+    static constexpr size_t terms = 1;
+    static constexpr bool products = true;
+
+    const MPInt<PA>& a;
+    const MPInt<PB>& b;
+
+    constexpr Product(const MPInt<PA>& a, const MPInt<PB>& b) : a(a), b(b) {}
+
+    template<typename Collector>
+    constexpr void collect(bool negate, Collector& out) const {
+        const Term ta = Access::term(a, false);
+        const Term tb = Access::term(b, false);
+        out.product({ta.limbs, ta.len, tb.limbs, tb.len, (ta.negative != tb.negative) != negate});
+    }
+
+    constexpr MPInt<precision> eval() const {
+        MPInt<precision> result;
+        evaluate(result, *this);
+        return result;
+    }
+    constexpr operator MPInt<precision>() const { return eval(); }
+};
+
+namespace detail {
+
+// r[from, to) += součet K členů (K je známé při překladu, takže se vnitřní smyčka rozbalí)
+template<size_t K>
+constexpr limb_t addSegment(limb_t* r, size_t from, size_t to, const Term* terms, limb_t carry) {
+    for (size_t i = from; i < to; ++i) {
+        // součet nejvýše K + 2 limbů se do 128 bitů vejde
+        mpn::dlimb_t acc = static_cast<mpn::dlimb_t>(r[i]) + carry;
+        for (size_t t = 0; t < K; ++t) acc += terms[t].limbs[i];
+        r[i] = static_cast<limb_t>(acc);
+        carry = static_cast<limb_t>(acc >> mpn::LIMB_BITS);
+    }
+    return carry;
+}
+
+constexpr limb_t addSegment(limb_t* r, size_t from, size_t to, const Term* terms, size_t count, limb_t carry) {
+    switch (count) {
+        case 0: return addSegment<0>(r, from, to, terms, carry);
+        case 1: return addSegment<1>(r, from, to, terms, carry);
+        case 2: return addSegment<2>(r, from, to, terms, carry);
+        case 3: return addSegment<3>(r, from, to, terms, carry);
+        default: break;
+    }
+    for (size_t i = from; i < to; ++i) {
+        mpn::dlimb_t acc = static_cast<mpn::dlimb_t>(r[i]) + carry;
+        for (size_t t = 0; t < count; ++t) acc += terms[t].limbs[i];
+        r[i] = static_cast<limb_t>(acc);
+        carry = static_cast<limb_t>(acc >> mpn::LIMB_BITS);
+    }
+    return carry;
+}
+
+} // namespace detail
+
+/*
+ * r[0, n) += součet členů, jeden průchod přes limby pro všechny členy najednou.
+ * Členy se seřadí podle délky, takže v každém úseku se sčítá pevný počet členů
+ * bez testu délky. Každý člen má nejvýše n limbů, vrací přenos nad n limbů.
+ */
+constexpr limb_t addTerms(limb_t* r, size_t n, Term* terms, size_t count) {
+    std::sort(terms, terms + count, [](const Term& a, const Term& b) { return a.len > b.len; });
+    limb_t carry = 0;
+    size_t i = 0;
+    for (size_t active = count; ; --active) {
+        // úsek, ve kterém má limby prvních active členů
+        const size_t end = active > 0 ? terms[active - 1].len : n;
+        if (end > i) {
+            carry = detail::addSegment(r, i, end, terms, active, carry);
+            i = end;
+        }
+        if (active == 0) break;
+    }
+    return carry;
+}
+
+// r = a * b, r má a_len + b_len limbů (operandy mohou být v libovolném pořadí a délce)
+constexpr void multiply(limb_t* r, const ProductTerm& p) {
+    if (p.a == p.b && p.a_len == p.b_len)
+        mpn::sqr(r, p.a, p.a_len);
+    else if (p.a_len >= p.b_len)
+        mpn::mul(r, p.a, p.a_len, p.b, p.b_len);
+    else
+        mpn::mul(r, p.b, p.b_len, p.a, p.a_len);
+}
+
+/*
+ * Vyhodnocení výrazu E do MPInt<P>.
+ */
+template<size_t P, LazyExpr E>
+constexpr void evaluate(MPInt<P>& result, const E& expr) {
+    constexpr size_t N = E::terms;
+    // horní mez délky pro omezenou přesnost (součin dvou čísel + limb na přenosy)
+    constexpr size_t EXPR_LIMBS = (E::precision + mpn::LIMB_BYTES - 1) / mpn::LIMB_BYTES;
+    constexpr size_t BOUND = (E::products ? 2 * EXPR_LIMBS : EXPR_LIMBS) + 1;
+
+    // sběr členů do polí na zásobníku
+    struct Collector {
+        std::array<Term, N> pos{}, neg{};
+        std::array<ProductTerm, N> products{};
+        size_t pos_count = 0, neg_count = 0, product_count = 0;
+        size_t width = 0;
+
+        constexpr void term(const Term& t) {
+            if (t.len == 0) return;
+            (t.negative ? neg[neg_count++] : pos[pos_count++]) = t;
+            width = std::max(width, t.len);
+        }
+        constexpr void product(const ProductTerm& p) {
+            if (p.a_len == 0 || p.b_len == 0) return;
+            products[product_count++] = p;
+            width = std::max(width, p.a_len + p.b_len);
+        }
+    } c;
+    expr.collect(false, c);
+    const size_t width = c.width + 1;
+
+    // akumulátory: Unlimited v LimbVector (výsledek si buffer převezme), Limited na zásobníku
+    using Buffer = std::conditional_t<E::precision == 0, mpn::LimbVector, std::array<limb_t, BOUND>>;
+    Buffer pos_buf{}, neg_buf{};
+    if constexpr (E::precision == 0) {
+        pos_buf.assign(width, 0);
+    }
+    // další součiny (první se počítá rovnou do akumulátoru) leží za sebou v jednom odkládacím bufferu
+    size_t extra_limbs = 0;
+    bool seen[2] = {false, false};   // první součin kladné a záporné strany
+    for (size_t i = 0; i < c.product_count; ++i) {
+        const ProductTerm& p = c.products[i];
+        if (seen[p.negative]) extra_limbs += p.a_len + p.b_len;
+        seen[p.negative] = true;
+    }
+    limb_t* extra = nullptr;
+
+    // jedna strana součtu: buď přímo jediný list (bez kopie), nebo akumulátor
+    auto side = [&](Buffer& buf, Term* terms, size_t& count, bool negative,
+                    const limb_t*& out, size_t& out_len) {
+        bool has_product = false;
+        for (size_t i = 0; i < c.product_count; ++i) {
+            const ProductTerm& p = c.products[i];
+            if (p.negative != negative) continue;
+            if constexpr (E::precision == 0) {
+                if (buf.size() < width) buf.assign(width, 0);
+            }
+            if (!has_product) {
+                multiply(buf.data(), p);
+                has_product = true;
+            }
+            else {
+                multiply(extra, p);
+                terms[count++] = {extra, p.a_len + p.b_len, negative};
+                extra += p.a_len + p.b_len;
+            }
+        }
+        if (!has_product && count == 1) {
+            out = terms[0].limbs;
+            out_len = terms[0].len;
+            return;
+        }
+        if (count > 0 || has_product) {
+            if constexpr (E::precision == 0) {
+                if (buf.size() < width) buf.assign(width, 0);
+            }
+            addTerms(buf.data(), width, terms, count);
+            out = buf.data();
+            out_len = mpn::normalize(buf.data(), width);
+        }
+    };
+
+    const limb_t* p = nullptr;
+    const limb_t* n = nullptr;
+    size_t p_len = 0, n_len = 0;
+    // členy v extra se sečtou do akumulátorů uvnitř side, p a n na extra nikdy neukazují
+    auto sides = [&](limb_t* scratch) {
+        extra = scratch;
+        side(pos_buf, c.pos.data(), c.pos_count, false, p, p_len);
+        side(neg_buf, c.neg.data(), c.neg_count, true, n, n_len);
+        return 0;
+    };
+    if (extra_limbs > 0) mpn::withScratch(extra_limbs, sides);
+    else sides(nullptr);
+
+    // výsledek = P - N do pos_buf (mpn::sub smí zapisovat do kteréhokoli ze vstupů)
+    bool negative = false;
+    size_t len;
+    if (n_len == 0) {
+        if (p != pos_buf.data()) std::copy_n(p, p_len, pos_buf.data());
+        len = p_len;
+    }
+    else if (mpn::cmp(p, p_len, n, n_len) >= 0) {
+        mpn::sub(pos_buf.data(), p, p_len, n, n_len);
+        len = p_len;
+    }
+    else {
+        mpn::sub(pos_buf.data(), n, n_len, p, p_len);
+        len = n_len;
+        negative = true;
+    }
+
+    if constexpr (P == 0 && E::precision == 0) {
+        pos_buf.resize(len);
+        Access::adopt(result, std::move(pos_buf), negative);
+    }
+    else {
+        Access::assign(result, pos_buf.data(), len, negative);
+    }
+}
+
+// jediný člen výrazu bez součinů (list jako MPIntView), přiřazení ho zkopíruje bez akumulátoru
+template<LazyExpr E>
+    requires (E::terms == 1 && !E::products)
+constexpr Term singleTerm(const E& expr) {
+    struct One {
+        Term t{nullptr, 0, false};
+        constexpr void term(const Term& x) { t = x; }
+    } one;
+    expr.collect(false, one);
+    return one.t;
+}
+
+// hodnota operandu: MPInt se jen předá, výraz se vyhodnotí
+template<size_t P>
+constexpr const MPInt<P>& value(const MPInt<P>& x) {
+    return x;
+}
+
+template<LazyExpr E>
+constexpr auto value(const E& e) {
+    return e.eval();
+}
+
+} // namespace mplazy
+
+/*
+ * -----------------------------------------------------------------------------
+ * Operátory vytvářející líné výrazy
+ * -----------------------------------------------------------------------------
+ */
+template<mplazy::Operand L, mplazy::Operand R>
+constexpr mplazy::Sum<L, R, false> operator+(const L& a, const R& b) {
+    return {a, b};
+}
+
+template<mplazy::Operand L, mplazy::Operand R>
+constexpr mplazy::Sum<L, R, true> operator-(const L& a, const R& b) {
+    return {a, b};
+}
+
+template<size_t PA, size_t PB>
+constexpr mplazy::Product<PA, PB> operator*(const MPInt<PA>& a, const MPInt<PB>& b) {
+    return {a, b};
+}
+
+// součin s výrazem se vyhodnotí hned (výsledek by jinak odkazoval na dočasný objekt)
+template<mplazy::Operand L, mplazy::Operand R>
+    requires (mplazy::LazyExpr<L> || mplazy::LazyExpr<R>)
+constexpr auto operator*(const L& a, const R& b) {
+    return (mplazy::value(a) * mplazy::value(b)).eval();
+}
+
+template<mplazy::Operand L, mplazy::Operand R>
+    requires (mplazy::LazyExpr<L> || mplazy::LazyExpr<R>)
+auto operator/(const L& a, const R& b) {
+    return mplazy::value(a) / mplazy::value(b);
+}
+
+template<mplazy::Operand L, mplazy::Operand R>
+    requires (mplazy::LazyExpr<L> || mplazy::LazyExpr<R>)
+auto operator%(const L& a, const R& b) {
+    return mplazy::value(a) % mplazy::value(b);
+}
+
+// výraz s nativním číslem vpravo
+template<mplazy::LazyExpr E, std::integral T>
+constexpr auto operator+(const E& a, const T b) {
+    return a.eval() + b;
+}
+
+template<mplazy::LazyExpr E, std::integral T>
+constexpr auto operator-(const E& a, const T b) {
+    return a.eval() - b;
+}
+
+template<mplazy::LazyExpr E, std::integral T>
+constexpr auto operator*(const E& a, const T b) {
+    return a.eval() * b;
+}
+
+template<mplazy::LazyExpr E, std::integral T>
+constexpr auto operator/(const E& a, const T b) {
+    return a.eval() / b;
+}
+
+template<mplazy::LazyExpr E, std::integral T>
+constexpr auto operator%(const E& a, const T b) {
+    return a.eval() % b;
+}
+
+// porovnání a výpis, pokud je aspoň jeden operand výraz
+template<mplazy::Operand L, mplazy::Operand R>
+    requires (mplazy::LazyExpr<L> || mplazy::LazyExpr<R>)
+constexpr bool operator==(const L& a, const R& b) {
+    return mplazy::value(a) == mplazy::value(b);
+}
+
+template<mplazy::Operand L, mplazy::Operand R>
+    requires (mplazy::LazyExpr<L> || mplazy::LazyExpr<R>)
+constexpr bool operator!=(const L& a, const R& b) {
+    return !(a == b);
+}
+
+template<mplazy::Operand L, mplazy::Operand R>
+    requires (mplazy::LazyExpr<L> || mplazy::LazyExpr<R>)
+constexpr bool operator<(const L& a, const R& b) {
+    return mplazy::value(a) < mplazy::value(b);
+}
+
+template<mplazy::Operand L, mplazy::Operand R>
+    requires (mplazy::LazyExpr<L> || mplazy::LazyExpr<R>)
+constexpr bool operator>(const L& a, const R& b) {
+    return b < a;
+}
+
+template<mplazy::Operand L, mplazy::Operand R>
+    requires (mplazy::LazyExpr<L> || mplazy::LazyExpr<R>)
+constexpr bool operator<=(const L& a, const R& b) {
+    return !(b < a);
+}
+
+template<mplazy::Operand L, mplazy::Operand R>
+    requires (mplazy::LazyExpr<L> || mplazy::LazyExpr<R>)
+constexpr bool operator>=(const L& a, const R& b) {
+    return !(a < b);
+}
+
+template<mplazy::LazyExpr E>
+std::ostream& operator<<(std::ostream& os, const E& e) {
+    return os << e.eval();
+}
+
+#endif
@@ -0,0 +1,444 @@
+#ifndef SEM_2_MPMUL_H
+#define SEM_2_MPMUL_H
+
+#include <algorithm>
+#include <utility>
+#include "mpn.h"
+#include "mparena.h"
+#include "mpntt.h"
+
+/*
+ * Násobící engine nad poli limbů.
+ * Podle velikosti operandů volí algoritmus:
+ * - školní násobení O(n^2) pro malá čísla,
+ * - Karatsuba O(n^1.58) od prahu karatsuba,
+ * - Toom-Cook 3 O(n^1.46) od prahu toom3,
+ * - NTT přes tři prvočísla O(n log n) od prahu ntt (viz mpntt.h).
+ * Nevyvážené operandy se násobí po blocích velikosti kratšího z nich.
+ */
+namespace mpn {
+
+// prahy (v limbech) pro přepnutí algoritmu, benchmark je může přeladit
+struct MulThresholds {
+    std::size_t karatsuba = 24;
+    std::size_t toom3 = 96;
+    std::size_t ntt = 6000;
+    // školní umocnění na druhou je levnější, takže se rekurze vyplatí až později
+    std::size_t sqr_karatsuba = 40;
+    std::size_t sqr_toom3 = 120;
+};
+inline MulThresholds mul_thresholds;
+
+namespace detail {
+
+// Karatsuba potřebuje aspoň 2 limby (jinak má horní polovina 0 limbů a rekurze se nezastaví),
+// proto prah pod 2 z mul_thresholds platí jako 2
+inline bool useKaratsuba(std::size_t n) {
+    return n >= std::max<std::size_t>(mul_thresholds.karatsuba, 2);
+}
+
+inline bool useSqrKaratsuba(std::size_t n) {
+    return n >= std::max<std::size_t>(mul_thresholds.sqr_karatsuba, 2);
+}
+
+// Toom-3 potřebuje alespoň jeden limb v nejvyšší třetině
+inline bool useToom3(std::size_t n) {
+    return n >= mul_thresholds.toom3 && n >= 9;
+}
+
+inline bool useSqrToom3(std::size_t n) {
+    return n >= mul_thresholds.sqr_toom3 && n >= 9;
+}
+
+// velikost pomocné paměti pro mul_n (v limbech)
+inline std::size_t mulScratch(std::size_t n) {
+    if (!useKaratsuba(n)) return 0;
+    if (useToom3(n)) {
+        const std::size_t len = (n + 2) / 3 + 1;
+        return 14 * len + mulScratch(len);
+    }
+    const std::size_t low = n - n / 2;
+    return 6 * low + 1 + mulScratch(low);
+}
+
+// velikost pomocné paměti pro sqr_n (stejné rozložení jako u mul_n)
+inline std::size_t sqrScratch(std::size_t n) {
+    if (!useSqrKaratsuba(n)) return 0;
+    if (useSqrToom3(n)) {
+        const std::size_t len = (n + 2) / 3 + 1;
+        return 14 * len + sqrScratch(len);
+    }
+    const std::size_t low = n - n / 2;
+    return 6 * low + 1 + sqrScratch(low);
+}
+
+// r = |a - b| pro a délky na a b délky nb <= na, r má na limbů, vrací true pokud a < b
+inline bool absDiff(limb_t* r, const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb) {
+    if (cmp(a, na, b, nb) >= 0) {
+        sub(r, a, na, b, nb);
+        return false;
+    }
+    // a < b, takže platná část a je kratší než nb
+    const std::size_t a_len = normalize(a, na);
+    sub(r, b, nb, a, a_len);
+    std::fill(r + nb, r + na, limb_t{0});
+    return true;
+}
+
+// dvojkový doplněk: r = -r (mod B^n)
+inline void negate(limb_t* r, std::size_t n) {
+    limb_t carry = 1;
+    for (std::size_t i = 0; i < n; ++i) {
+        const limb_t x = ~r[i] + carry;
+        carry = carry && x == 0;
+        r[i] = x;
+    }
+}
+
+// aritmetický posun doprava o 1 bit (přesné dělení 2 ve dvojkovém doplňku)
+inline void shr1Signed(limb_t* r, std::size_t n) {
+    const limb_t sign = r[n - 1] & (limb_t{1} << (LIMB_BITS - 1));
+    rshift(r, r, n, 1);
+    r[n - 1] |= sign;
+}
+
+// přesné dělení 3 (mod B^n), funguje i pro záporná čísla ve dvojkovém doplňku
+inline void divExact3(limb_t* r, std::size_t n) {
+    constexpr limb_t inv3 = 0xAAAAAAAAAAAAAAABull;  // 3 * inv3 = 1 (mod 2^64)
+    limb_t borrow = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const limb_t s = r[i];
+        limb_t l = s - borrow;
+        borrow = l > s;
+        l *= inv3;
+        r[i] = l;
+        borrow += static_cast<limb_t>((static_cast<dlimb_t>(l) * 3) >> LIMB_BITS);
+    }
+}
+
+// převod z dvojkového doplňku na absolutní hodnotu, vrací true pro záporné číslo
+inline bool toMagnitude(limb_t* r, std::size_t n) {
+    if ((r[n - 1] >> (LIMB_BITS - 1)) == 0) return false;
+    negate(r, n);
+    return true;
+}
+
+// r += x * B^offset, r má rn limbů a výsledek se do nich musí vejít
+inline void addShifted(limb_t* r, std::size_t rn, std::size_t offset, const limb_t* x, std::size_t xn) {
+    xn = normalize(x, xn);
+    if (xn == 0) return;
+    add(r + offset, r + offset, rn - offset, x, xn);
+}
+
+inline void mul_n(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n, limb_t* scratch);
+inline void sqr_n(limb_t* r, const limb_t* a, std::size_t n, limb_t* scratch);
+
+/*
+ * Karatsuba (odčítací varianta): a = a1 * B^low + a0, b = b1 * B^low + b0
+ * a*b = z2 * B^(2low) + (z0 + z2 - (a0 - a1)(b0 - b1)) * B^low + z0
+ */
+inline void karatsuba(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n, limb_t* scratch) {
+    const std::size_t low = n - n / 2;
+    const std::size_t hi = n / 2;
+
+    limb_t* da = scratch;               // |a0 - a1|
+    limb_t* db = da + low;              // |b0 - b1|
+    limb_t* t = db + low;               // da * db
+    limb_t* mid = t + 2 * low;          // prostřední koeficient
+    limb_t* next = mid + 2 * low + 1;   // pomocná paměť pro rekurzi
+
+    const bool a_neg = absDiff(da, a, low, a + low, hi);
+    const bool b_neg = absDiff(db, b, low, b + low, hi);
+
+    mul_n(r, a, b, low, next);                      // z0
+    mul_n(r + 2 * low, a + low, b + low, hi, next); // z2
+    mul_n(t, da, db, low, next);
+
+    // mid = z0 + z2 -+ t
+    std::copy_n(r, 2 * low, mid);
+    mid[2 * low] = add(mid, mid, 2 * low, r + 2 * low, 2 * hi);
+    if (a_neg != b_neg)
+        add(mid, mid, 2 * low + 1, t, 2 * low);
+    else
+        sub(mid, mid, 2 * low + 1, t, 2 * low);
+
+    addShifted(r, 2 * n, low, mid, 2 * low + 1);
+}
+
+// Karatsuba pro druhou mocninu: a^2 = z2 * B^(2low) + (z0 + z2 - (a0 - a1)^2) * B^low + z0
+inline void karatsubaSqr(limb_t* r, const limb_t* a, std::size_t n, limb_t* scratch) {
+    const std::size_t low = n - n / 2;
+    const std::size_t hi = n / 2;
+
+    limb_t* da = scratch;               // |a0 - a1|
+    limb_t* t = da + 2 * low;           // da^2
+    limb_t* mid = t + 2 * low;          // prostřední koeficient
+    limb_t* next = mid + 2 * low + 1;   // pomocná paměť pro rekurzi
+
+    absDiff(da, a, low, a + low, hi);
+
+    sqr_n(r, a, low, next);                 // z0
+    sqr_n(r + 2 * low, a + low, hi, next);  // z2
+    sqr_n(t, da, low, next);
+
+    // mid = z0 + z2 - t (druhá mocnina je nezáporná, znaménko rozdílu nehraje roli)
+    std::copy_n(r, 2 * low, mid);
+    mid[2 * low] = add(mid, mid, 2 * low, r + 2 * low, 2 * hi);
+    sub(mid, mid, 2 * low + 1, t, 2 * low);
+
+    addShifted(r, 2 * n, low, mid, 2 * low + 1);
+}
+
+inline void toom3Interpolate(limb_t* r, std::size_t n, std::size_t k,
+                             limb_t* r1, limb_t* rm1, limb_t* rm2, limb_t* r3);
+
+/*
+ * Toom-Cook 3: čísla rozdělíme na třetiny délky k a vyhodnotíme polynomy
+ * v bodech 0, 1, -1, -2 a nekonečnu. Interpolace podle Bodrata pracuje
+ * ve dvojkovém doplňku na pevné šířce, takže záporné mezivýsledky nevadí.
+ */
+inline void toom3(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n, limb_t* scratch) {
+    const std::size_t k = (n + 2) / 3;
+    const std::size_t top = n - 2 * k;      // délka nejvyšší třetiny (>= 1)
+    const std::size_t len = k + 1;          // délka hodnot v bodech
+    const std::size_t width = 2 * len;      // délka součinů a interpolace
+
+    limb_t* pa1 = scratch;
+    limb_t* pam1 = pa1 + len;
+    limb_t* pam2 = pam1 + len;
+    limb_t* pb1 = pam2 + len;
+    limb_t* pbm1 = pb1 + len;
+    limb_t* pbm2 = pbm1 + len;
+    limb_t* r1 = pbm2 + len;
+    limb_t* rm1 = r1 + width;
+    limb_t* rm2 = rm1 + width;
+    limb_t* r3 = rm2 + width;
+    limb_t* next = r3 + width;
+
+    // vyhodnocení ve dvojkovém doplňku na len limbech, vrací znaménka hodnot v -1 a -2
+    auto evaluate = [&](const limb_t* x, limb_t* p1, limb_t* pm1, limb_t* pm2) {
+        const limb_t* x0 = x;
+        const limb_t* x1 = x + k;
+        const limb_t* x2 = x + 2 * k;
+        // p1 = x0 + x2, pm1 = p1 - x1, p1 = p1 + x1
+        std::copy_n(x0, k, p1);
+        p1[k] = add(p1, p1, k, x2, top);
+        std::copy_n(p1, len, pm1);
+        sub(pm1, pm1, len, x1, k);
+        add(p1, p1, len, x1, k);
+        // pm2 = 2 * (pm1 + x2) - x0
+        std::copy_n(pm1, len, pm2);
+        add(pm2, pm2, len, x2, top);
+        lshift(pm2, pm2, len, 1);
+        sub(pm2, pm2, len, x0, k);
+        const bool neg1 = toMagnitude(pm1, len);
+        const bool neg2 = toMagnitude(pm2, len);
+        return std::pair{neg1, neg2};
+    };
+    const auto [a_neg1, a_neg2] = evaluate(a, pa1, pam1, pam2);
+    const auto [b_neg1, b_neg2] = evaluate(b, pb1, pbm1, pbm2);
+
+    // součiny v bodech, r0 a rinf rovnou na svá místa ve výsledku
+    std::fill(r + 2 * k, r + 4 * k, limb_t{0});
+    mul_n(r, a, b, k, next);
+    mul_n(r + 4 * k, a + 2 * k, b + 2 * k, top, next);
+    mul_n(r1, pa1, pb1, len, next);
+    mul_n(rm1, pam1, pbm1, len, next);
+    mul_n(rm2, pam2, pbm2, len, next);
+    if (a_neg1 != b_neg1) negate(rm1, width);
+    if (a_neg2 != b_neg2) negate(rm2, width);
+
+    toom3Interpolate(r, n, k, r1, rm1, rm2, r3);
+}
+
+/*
+ * Interpolace Toom-3 (Bodrato). r0 a rinf už leží na svých místech v r,
+ * r1, rm1, rm2 jsou součiny v bodech 1, -1, -2 ve dvojkovém doplňku, r3 je pomocné pole,
+ * všechna mají 2(k + 1) limbů a přepíšou se.
+ */
+inline void toom3Interpolate(limb_t* r, std::size_t n, std::size_t k,
+                             limb_t* r1, limb_t* rm1, limb_t* rm2, limb_t* r3) {
+    const std::size_t width = 2 * (k + 1);
+    const limb_t* r0 = r;
+    const limb_t* rinf = r + 4 * k;
+    const std::size_t rinf_len = 2 * (n - 2 * k);
+
+    // interpolace (Bodrato):
+    // r3 = (rm2 - r1) / 3
+    std::copy_n(rm2, width, r3);
+    sub(r3, r3, width, r1, width);
+    divExact3(r3, width);
+    // r1 = (r1 - rm1) / 2
+    sub(r1, r1, width, rm1, width);
+    shr1Signed(r1, width);
+    // r2 = rm1 - r0 (do rm1)
+    limb_t* r2 = rm1;
+    sub(r2, r2, width, r0, 2 * k);
+    // r3 = (r2 - r3) / 2 + 2 * rinf
+    sub(r3, r2, width, r3, width);
+    shr1Signed(r3, width);
+    add(r3, r3, width, rinf, rinf_len);
+    add(r3, r3, width, rinf, rinf_len);
+    // r2 = r2 + r1 - rinf
+    add(r2, r2, width, r1, width);
+    sub(r2, r2, width, rinf, rinf_len);
+    // r1 = r1 - r3
+    sub(r1, r1, width, r3, width);
+
+    // složení výsledku, koeficienty r1, r2, r3 jsou nezáporné
+    addShifted(r, 2 * n, k, r1, width);
+    addShifted(r, 2 * n, 2 * k, r2, width);
+    addShifted(r, 2 * n, 3 * k, r3, width);
+}
+
+// Toom-3 pro druhou mocninu: jedno vyhodnocení, druhé mocniny v bodech jsou nezáporné
+inline void toom3Sqr(limb_t* r, const limb_t* a, std::size_t n, limb_t* scratch) {
+    const std::size_t k = (n + 2) / 3;
+    const std::size_t top = n - 2 * k;
+    const std::size_t len = k + 1;
+    const std::size_t width = 2 * len;
+
+    limb_t* p1 = scratch;
+    limb_t* pm1 = p1 + len;
+    limb_t* pm2 = pm1 + len;
+    limb_t* r1 = pm2 + len;
+    limb_t* rm1 = r1 + width;
+    limb_t* rm2 = rm1 + width;
+    limb_t* r3 = rm2 + width;
+    limb_t* next = r3 + width;
+
+    const limb_t* a0 = a;
+    const limb_t* a1 = a + k;
+    const limb_t* a2 = a + 2 * k;
+    // stejné vyhodnocení jako v toom3
+    std::copy_n(a0, k, p1);
+    p1[k] = add(p1, p1, k, a2, top);
+    std::copy_n(p1, len, pm1);
+    sub(pm1, pm1, len, a1, k);
+    add(p1, p1, len, a1, k);
+    std::copy_n(pm1, len, pm2);
+    add(pm2, pm2, len, a2, top);
+    lshift(pm2, pm2, len, 1);
+    sub(pm2, pm2, len, a0, k);
+    toMagnitude(pm1, len);
+    toMagnitude(pm2, len);
+
+    std::fill(r + 2 * k, r + 4 * k, limb_t{0});
+    sqr_n(r, a0, k, next);
+    sqr_n(r + 4 * k, a2, top, next);
+    sqr_n(r1, p1, len, next);
+    sqr_n(rm1, pm1, len, next);
+    sqr_n(rm2, pm2, len, next);
+
+    toom3Interpolate(r, n, k, r1, rm1, rm2, r3);
+}
+
+// r = a * b pro stejně dlouhé operandy, r má 2n limbů
+inline void mul_n(limb_t* r, const limb_t* a, const limb_t* b, std::size_t n, limb_t* scratch) {
+    if (!useKaratsuba(n)) {
+        mul_basecase(r, a, n, b, n);
+    }
+    else if (useToom3(n)) {
+        toom3(r, a, b, n, scratch);
+    }
+    else {
+        karatsuba(r, a, b, n, scratch);
+    }
+}
+
+// r = a^2, r má 2n limbů
+inline void sqr_n(limb_t* r, const limb_t* a, std::size_t n, limb_t* scratch) {
+    if (!useSqrKaratsuba(n)) {
+        sqr_basecase(r, a, n);
+    }
+    else if (useSqrToom3(n)) {
+        toom3Sqr(r, a, n, scratch);
+    }
+    else {
+        karatsubaSqr(r, a, n, scratch);
+    }
+}
+
+} // namespace detail
+
+/*
+ * r = a^2, n >= 1.
+ * r musí mít 2n limbů a nesmí se překrývat s a.
+ */
+namespace detail {
+
+// Karatsuba a Toom-3 potřebují odkládací paměť z arény, proto nejsou constexpr
+inline void sqrLarge(limb_t* r, const limb_t* a, std::size_t n) {
+    ScratchBuffer scratch(sqrScratch(n));
+    sqr_n(r, a, n, scratch.data());
+}
+
+inline void mulLarge(limb_t* r, const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb);
+
+} // namespace detail
+
+// při překladu (constexpr) se násobí jen školní metodou, ostatní algoritmy potřebují arénu nebo NTT tabulky
+constexpr void sqr(limb_t* r, const limb_t* a, std::size_t n) {
+    if (std::is_constant_evaluated() || !detail::useSqrKaratsuba(n)) {
+        sqr_basecase(r, a, n);
+        return;
+    }
+    if (n >= mul_thresholds.ntt && 2 * n - 1 <= (std::size_t{1} << ntt::MAX_LOG)) {
+        mul_ntt(r, a, n, a, n);
+        return;
+    }
+    detail::sqrLarge(r, a, n);
+}
+
+/*
+ * r = a * b, předpokládá na >= nb >= 1.
+ * r musí mít na + nb limbů a nesmí se překrývat s a ani b.
+ */
+constexpr void mul(limb_t* r, const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb) {
+    if (std::is_constant_evaluated()) {
+        mul_basecase(r, a, na, b, nb);
+        return;
+    }
+    if (a == b && na == nb) {
+        sqr(r, a, na);
+        return;
+    }
+    if (!detail::useKaratsuba(nb)) {
+        mul_basecase(r, a, na, b, nb);
+        return;
+    }
+    if (nb >= mul_thresholds.ntt && na + nb - 1 <= (std::size_t{1} << ntt::MAX_LOG)) {
+        mul_ntt(r, a, na, b, nb);
+        return;
+    }
+    detail::mulLarge(r, a, na, b, nb);
+}
+
+namespace detail {
+
+// Karatsuba / Toom-3, nevyvážené operandy po blocích délky nb
+inline void mulLarge(limb_t* r, const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb) {
+    ScratchBuffer scratch(mulScratch(nb));
+    if (na == nb) {
+        mul_n(r, a, b, nb, scratch.data());
+        return;
+    }
+
+    // nevyvážené operandy: a rozdělíme na bloky délky nb a součiny sečteme
+    std::fill(r, r + na + nb, limb_t{0});
+    ScratchBuffer block(2 * nb);
+    for (std::size_t offset = 0; offset < na; offset += nb) {
+        const std::size_t chunk = std::min(nb, na - offset);
+        if (chunk == nb)
+            mul_n(block.data(), a + offset, b, nb, scratch.data());
+        else
+            mul(block.data(), b, nb, a + offset, chunk);
+        add(r + offset, r + offset, na + nb - offset, block.data(), chunk + nb);
+    }
+}
+
+} // namespace detail
+
+} // namespace mpn
+
+#endif
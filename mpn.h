@@ -0,0 +1,178 @@
+#ifndef SEM_2_MPN_H
+#define SEM_2_MPN_H
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include "mpsimd.h"
+
+/*
+ * Nízkoúrovňové jádro aritmetiky nad poli limbů (mpn = "multi-precision natural").
+ * - Limb je 64bitové slovo, mezivýsledky se počítají v 128 bitech (unsigned __int128).
+ * - Všechna pole jsou Little Endian (nejméně významný limb na indexu 0).
+ * - Funkce nepracují se znaménkem ani s alokací paměti, jen s ukazateli a délkami,
+ *   takže je může používat std::vector i std::array uložiště MPInt.
+ * - Sčítání, odčítání a porovnání dlouhých polí běží na vektorových jádrech,
+ *   pokud je procesor má (viz mpsimd.h).
+ * - Funkce jsou constexpr, takže je může použít i MPInt vyhodnocované při překladu;
+ *   vektorová jádra se v tom případě přeskočí.
+ */
+namespace mpn {
+
+using limb_t = std::uint64_t;
+using dlimb_t = unsigned __int128;
+
+constexpr unsigned LIMB_BITS = 64;
+constexpr std::size_t LIMB_BYTES = sizeof(limb_t);
+
+// délka pole bez nulových limbů na nejvyšších pozicích
+constexpr std::size_t normalize(const limb_t* a, std::size_t n) {
+    while (n > 0 && a[n - 1] == 0) --n;
+    return n;
+}
+
+// porovnání absolutních hodnot, pole nemusí být normalizovaná
+constexpr int cmp(const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb) {
+    na = normalize(a, na);
+    nb = normalize(b, nb);
+    if (na != nb) return na > nb ? 1 : -1;
+    const std::size_t top = !std::is_constant_evaluated() && na >= simd::THRESHOLD ? simd::skipEqualTop(a, b, na) : na;
+    for (std::size_t i = top; i > 0; --i) {
+        if (a[i - 1] != b[i - 1]) return a[i - 1] > b[i - 1] ? 1 : -1;
+    }
+    return 0;
+}
+
+// r = a + b, předpokládá na >= nb, r má na limbů (smí být totéž co a), vrací přenos
+constexpr limb_t add(limb_t* r, const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb) {
+    limb_t carry = 0;
+    std::size_t i = !std::is_constant_evaluated() && nb >= simd::THRESHOLD ? simd::add(r, a, b, nb, carry) : 0;
+    for (; i < nb; ++i) {
+        const dlimb_t sum = static_cast<dlimb_t>(a[i]) + b[i] + carry;
+        r[i] = static_cast<limb_t>(sum);
+        carry = static_cast<limb_t>(sum >> LIMB_BITS);
+    }
+    for (; i < na; ++i) {
+        const limb_t sum = a[i] + carry;
+        carry = sum < carry;
+        r[i] = sum;
+    }
+    return carry;
+}
+
+// r = a - b, předpokládá na >= nb, r má na limbů (smí být totéž co a nebo b), vrací výpůjčku
+constexpr limb_t sub(limb_t* r, const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb) {
+    limb_t borrow = 0;
+    std::size_t i = !std::is_constant_evaluated() && nb >= simd::THRESHOLD ? simd::sub(r, a, b, nb, borrow) : 0;
+    for (; i < nb; ++i) {
+        const limb_t diff = a[i] - b[i];
+        const limb_t borrow1 = a[i] < b[i];
+        r[i] = diff - borrow;
+        borrow = borrow1 | (diff < borrow);
+    }
+    for (; i < na; ++i) {
+        const limb_t diff = a[i] - borrow;
+        borrow = a[i] < borrow;
+        r[i] = diff;
+    }
+    return borrow;
+}
+
+// r = a * b (jeden limb), r má n limbů, vrací horní limb výsledku
+constexpr limb_t mul_1(limb_t* r, const limb_t* a, std::size_t n, limb_t b) {
+    limb_t carry = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const dlimb_t prod = static_cast<dlimb_t>(a[i]) * b + carry;
+        r[i] = static_cast<limb_t>(prod);
+        carry = static_cast<limb_t>(prod >> LIMB_BITS);
+    }
+    return carry;
+}
+
+// r += a * b (jeden limb), vrací přenos nad n limbů
+constexpr limb_t addmul_1(limb_t* r, const limb_t* a, std::size_t n, limb_t b) {
+    limb_t carry = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        // (2^64 - 1)^2 + 2 * (2^64 - 1) se do 128 bitů ještě vejde
+        const dlimb_t prod = static_cast<dlimb_t>(a[i]) * b + r[i] + carry;
+        r[i] = static_cast<limb_t>(prod);
+        carry = static_cast<limb_t>(prod >> LIMB_BITS);
+    }
+    return carry;
+}
+
+// r -= a * b (jeden limb), vrací výpůjčku nad n limbů
+constexpr limb_t submul_1(limb_t* r, const limb_t* a, std::size_t n, limb_t b) {
+    limb_t borrow = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const dlimb_t prod = static_cast<dlimb_t>(a[i]) * b + borrow;
+        const limb_t low = static_cast<limb_t>(prod);
+        borrow = static_cast<limb_t>(prod >> LIMB_BITS) + (r[i] < low);
+        r[i] -= low;
+    }
+    return borrow;
+}
+
+/*
+ * Školní násobení: r = a * b.
+ * r musí mít na + nb limbů a nesmí se překrývat s a ani b, na i nb >= 1.
+ */
+constexpr void mul_basecase(limb_t* r, const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb) {
+    r[na] = mul_1(r, a, na, b[0]);
+    for (std::size_t j = 1; j < nb; ++j) {
+        r[na + j] = addmul_1(r + j, a, na, b[j]);
+    }
+}
+
+// r = a << cnt (0 < cnt < 64), r má n limbů, vrací vysunuté bity
+constexpr limb_t lshift(limb_t* r, const limb_t* a, std::size_t n, unsigned cnt) {
+    limb_t out = 0;
+    for (std::size_t i = n; i > 0; --i) {
+        const limb_t x = a[i - 1];
+        if (i == n) out = x >> (LIMB_BITS - cnt);
+        r[i - 1] = (x << cnt) | (i > 1 ? a[i - 2] >> (LIMB_BITS - cnt) : 0);
+    }
+    return out;
+}
+
+// r = a >> cnt (0 < cnt < 64), r má n limbů
+constexpr void rshift(limb_t* r, const limb_t* a, std::size_t n, unsigned cnt) {
+    for (std::size_t i = 0; i < n; ++i) {
+        r[i] = (a[i] >> cnt) | (i + 1 < n ? a[i + 1] << (LIMB_BITS - cnt) : 0);
+    }
+}
+
+/*
+ * Školní umocnění na druhou: r = a^2.
+ * Součiny a_i * a_j pro i < j se spočítají jen jednou, zdvojnásobí se posunem
+ * a nakonec se přičte diagonála a_i^2 - zhruba polovina násobení oproti mul_basecase.
+ * r musí mít 2n limbů a nesmí se překrývat s a, n >= 1.
+ */
+constexpr void sqr_basecase(limb_t* r, const limb_t* a, std::size_t n) {
+    r[0] = 0;
+    r[2 * n - 1] = 0;
+    if (n > 1) {
+        // trojúhelník součinů mimo diagonálu, řádek i začíná na pozici 2i + 1
+        r[n] = mul_1(r + 1, a + 1, n - 1, a[0]);
+        for (std::size_t i = 1; i + 1 < n; ++i) {
+            r[n + i] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+        }
+        r[2 * n - 1] = lshift(r + 1, r + 1, 2 * n - 2, 1);
+    }
+
+    // diagonála
+    limb_t carry = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const dlimb_t sq = static_cast<dlimb_t>(a[i]) * a[i];
+        const dlimb_t lo = static_cast<dlimb_t>(r[2 * i]) + static_cast<limb_t>(sq) + carry;
+        r[2 * i] = static_cast<limb_t>(lo);
+        const dlimb_t hi = static_cast<dlimb_t>(r[2 * i + 1]) + static_cast<limb_t>(sq >> LIMB_BITS)
+                         + static_cast<limb_t>(lo >> LIMB_BITS);
+        r[2 * i + 1] = static_cast<limb_t>(hi);
+        carry = static_cast<limb_t>(hi >> LIMB_BITS);
+    }
+}
+
+} // namespace mpn
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef SEM_2_MPNTT_H
+#define SEM_2_MPNTT_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include "mpn.h"
+#include "mparena.h"
+
+/*
+ * Násobení obrovských čísel pomocí číselně-teoretické transformace (NTT).
+ * - Koeficienty jsou přímo 64bitové limby, konvoluce se spočítá modulo tří
+ *   62bitových prvočísel tvaru c * 2^k + 1 a výsledek se složí čínskou větou
+ *   o zbytcích (Garnerův algoritmus).
+ * - Součin prvočísel má 186 bitů, koeficient konvoluce je menší než N * 2^128,
+ *   takže pro délky do 2^39 je výsledek přesný - žádné zaokrouhlování jako u FFT.
+ * - Modulární násobení používá Montgomeryho redukci se 128bitovým mezivýsledkem.
+ */
+namespace mpn {
+
+namespace ntt {
+
+// prvočíslo pro NTT a jeho konstanty pro Montgomeryho aritmetiku (R = 2^64)
+struct Prime {
+    limb_t p;
+    limb_t root;        // primitivní kořen
+    unsigned max_log;   // p - 1 je dělitelné 2^max_log
+    limb_t inv;         // p^-1 mod 2^64
+    limb_t r2;          // R^2 mod p
+
+    constexpr Prime(limb_t p_, limb_t root_, unsigned max_log_)
+        : p(p_), root(root_), max_log(max_log_), inv(1), r2(0) {
+        // Newtonova iterace pro inverzi modulo 2^64 (každý krok zdvojí platné bity)
+        for (int i = 0; i < 6; ++i) inv *= 2 - p * inv;
+        const dlimb_t r = (static_cast<dlimb_t>(1) << LIMB_BITS) % p;
+        r2 = static_cast<limb_t>((r * r) % p);
+    }
+
+    // Montgomeryho násobení: a * b * R^-1 mod p, platí pro a * b < p * 2^64
+    limb_t mul(limb_t a, limb_t b) const {
+        const dlimb_t t = static_cast<dlimb_t>(a) * b;
+        const limb_t m = static_cast<limb_t>(t) * inv;
+        const limb_t t_hi = static_cast<limb_t>(t >> LIMB_BITS);
+        const limb_t mp_hi = static_cast<limb_t>((static_cast<dlimb_t>(m) * p) >> LIMB_BITS);
+        const limb_t res = t_hi - mp_hi;
+        return t_hi < mp_hi ? res + p : res;
+    }
+    limb_t add(limb_t a, limb_t b) const {
+        const limb_t s = a + b;
+        return s >= p ? s - p : s;
+    }
+    limb_t sub(limb_t a, limb_t b) const {
+        return a >= b ? a - b : a - b + p;
+    }
+    // převod do Montgomeryho tvaru (x smí být libovolný limb)
+    limb_t toMont(limb_t x) const {
+        return mul(x, r2);
+    }
+    // mocnina v Montgomeryho tvaru
+    limb_t pow(limb_t base_mont, limb_t e) const {
+        limb_t result = toMont(1);
+        while (e > 0) {
+            if (e & 1) result = mul(result, base_mont);
+            base_mont = mul(base_mont, base_mont);
+            e >>= 1;
+        }
+        return result;
+    }
+};
+
+inline constexpr std::array<Prime, 3> primes = {
+    Prime(4611546380450660353ull, 5, 40),   // 4194177 * 2^40 + 1
+    Prime(4611524390218104833ull, 3, 40),   // 4194157 * 2^40 + 1
+    Prime(4611627194555301889ull, 7, 39),   // 8388501 * 2^39 + 1
+};
+
+// největší podporovaná délka transformace
+inline constexpr unsigned MAX_LOG = 39;
+
+/*
+ * Tabulka kořenů jedničky v Montgomeryho tvaru: roots[len + j] = w_{2len}^j.
+ * Pro inverzní transformaci se použije inverzní kořen.
+ */
+inline void buildRoots(const Prime& pr, std::size_t n, bool inverse, limb_t* roots) {
+    const std::size_t half = n / 2;
+    limb_t w = pr.pow(pr.toMont(pr.root), (pr.p - 1) / n);
+    if (inverse) w = pr.pow(w, n - 1);
+    limb_t cur = pr.toMont(1);
+    for (std::size_t j = 0; j < half; ++j) {
+        roots[half + j] = cur;
+        cur = pr.mul(cur, w);
+    }
+    for (std::size_t len = half / 2; len >= 1; len /= 2) {
+        for (std::size_t j = 0; j < len; ++j) roots[len + j] = roots[2 * len + 2 * j];
+    }
+}
+
+// dopředná transformace (Gentleman-Sande), přirozené pořadí -> bitově obrácené
+inline void forward(const Prime& pr, limb_t* a, std::size_t n, const limb_t* roots) {
+    for (std::size_t len = n / 2; len >= 1; len /= 2) {
+        for (std::size_t start = 0; start < n; start += 2 * len) {
+            limb_t* x = a + start;
+            limb_t* y = x + len;
+            for (std::size_t j = 0; j < len; ++j) {
+                const limb_t u = x[j];
+                const limb_t v = y[j];
+                x[j] = pr.add(u, v);
+                y[j] = pr.mul(pr.sub(u, v), roots[len + j]);
+            }
+        }
+    }
+}
+
+// inverzní transformace (Cooley-Tukey), bitově obrácené pořadí -> přirozené, bez dělení n
+inline void inverse(const Prime& pr, limb_t* a, std::size_t n, const limb_t* roots) {
+    for (std::size_t len = 1; len < n; len *= 2) {
+        for (std::size_t start = 0; start < n; start += 2 * len) {
+            limb_t* x = a + start;
+            limb_t* y = x + len;
+            for (std::size_t j = 0; j < len; ++j) {
+                const limb_t u = x[j];
+                const limb_t v = pr.mul(y[j], roots[len + j]);
+                x[j] = pr.add(u, v);
+                y[j] = pr.sub(u, v);
+            }
+        }
+    }
+}
+
+/*
+ * Cyklická konvoluce a * b modulo jednoho prvočísla, výsledek (v normálním tvaru) skončí v out.
+ * fb je pomocné pole délky n, pro a == b se nepoužije, roots je pole n limbů pro kořeny.
+ */
+inline void convolve(const Prime& pr, const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb,
+                     std::size_t n, limb_t* out, limb_t* fb, limb_t* roots) {
+    const bool square = a == b && na == nb;
+    for (std::size_t i = 0; i < n; ++i) out[i] = i < na ? pr.toMont(a[i]) : 0;
+
+    buildRoots(pr, n, false, roots);
+    forward(pr, out, n, roots);
+    if (square) {
+        // druhá mocnina: stačí jedna dopředná transformace
+        for (std::size_t i = 0; i < n; ++i) out[i] = pr.mul(out[i], out[i]);
+    }
+    else {
+        for (std::size_t i = 0; i < n; ++i) fb[i] = i < nb ? pr.toMont(b[i]) : 0;
+        forward(pr, fb, n, roots);
+        for (std::size_t i = 0; i < n; ++i) out[i] = pr.mul(out[i], fb[i]);
+    }
+
+    buildRoots(pr, n, true, roots);
+    inverse(pr, out, n, roots);
+
+    // převod z Montgomeryho tvaru spojený s dělením n: x * R * n^-1 * R^-1
+    const limb_t n_inv = pr.pow(pr.toMont(n % pr.p), pr.p - 2);  // (n^-1) * R
+    const limb_t n_inv_plain = pr.mul(n_inv, 1);                  // n^-1
+    for (std::size_t i = 0; i < n; ++i) out[i] = pr.mul(out[i], n_inv_plain);
+}
+
+} // namespace ntt
+
+/*
+ * r = a * b pomocí tří NTT a CRT, předpokládá na >= nb >= 1.
+ * r musí mít na + nb limbů a nesmí se překrývat s a ani b, a == b znamená druhou mocninu.
+ */
+inline void mul_ntt(limb_t* r, const limb_t* a, std::size_t na, const limb_t* b, std::size_t nb) {
+    using ntt::primes;
+    const std::size_t coeffs = na + nb - 1;
+    const std::size_t n = std::bit_ceil(coeffs);
+
+    ScratchBuffer residues(3 * n);
+    ScratchBuffer fb(a == b && na == nb ? 0 : n);
+    ScratchBuffer roots(n);
+    for (std::size_t k = 0; k < primes.size(); ++k) {
+        ntt::convolve(primes[k], a, na, b, nb, n, residues.data() + k * n, fb.data(), roots.data());
+    }
+
+    // konstanty pro Garnerův algoritmus (v Montgomeryho tvaru, násobí se normálními čísly)
+    const ntt::Prime& p1 = primes[0];
+    const ntt::Prime& p2 = primes[1];
+    const ntt::Prime& p3 = primes[2];
+    const limb_t p1_inv_p2 = p2.pow(p2.toMont(p1.p % p2.p), p2.p - 2);  // p1^-1 mod p2
+    const limb_t p1_inv_p3 = p3.pow(p3.toMont(p1.p % p3.p), p3.p - 2);  // p1^-1 mod p3
+    const limb_t p2_inv_p3 = p3.pow(p3.toMont(p2.p % p3.p), p3.p - 2);  // p2^-1 mod p3
+    const dlimb_t p12 = static_cast<dlimb_t>(p1.p) * p2.p;
+    const limb_t p12_lo = static_cast<limb_t>(p12);
+    const limb_t p12_hi = static_cast<limb_t>(p12 >> LIMB_BITS);
+
+    // x = v1 + v2 * p1 + v3 * p1 * p2, přičítáme do tří limbového akumulátoru
+    limb_t acc0 = 0, acc1 = 0, acc2 = 0;
+    for (std::size_t i = 0; i < na + nb; ++i) {
+        if (i < coeffs) {
+            const limb_t v1 = residues[i];
+            const limb_t v1_p2 = v1 >= p2.p ? v1 - p2.p : v1;
+            const limb_t v2 = p2.mul(p2.sub(residues[n + i], v1_p2), p1_inv_p2);
+            const limb_t t = p3.mul(p3.sub(residues[2 * n + i], v1), p1_inv_p3);
+            const limb_t v3 = p3.mul(p3.sub(t, v2), p2_inv_p3);
+
+            // y = v1 + v2 * p1 (< 2^125)
+            const dlimb_t y = static_cast<dlimb_t>(v2) * p1.p + v1;
+            // z = v3 * p1 * p2 (tři limby)
+            const dlimb_t z_lo = static_cast<dlimb_t>(v3) * p12_lo;
+            const dlimb_t z_hi = static_cast<dlimb_t>(v3) * p12_hi + static_cast<limb_t>(z_lo >> LIMB_BITS);
+
+            const limb_t x[3] = {static_cast<limb_t>(z_lo), static_cast<limb_t>(z_hi),
+                                 static_cast<limb_t>(z_hi >> LIMB_BITS)};
+            const limb_t y_limbs[2] = {static_cast<limb_t>(y), static_cast<limb_t>(y >> LIMB_BITS)};
+            limb_t acc[3] = {acc0, acc1, acc2};
+            add(acc, acc, 3, x, 3);
+            add(acc, acc, 3, y_limbs, 2);
+            acc0 = acc[0];
+            acc1 = acc[1];
+            acc2 = acc[2];
+        }
+        r[i] = acc0;
+        acc0 = acc1;
+        acc1 = acc2;
+        acc2 = 0;
+    }
+}
+
+} // namespace mpn
+
+#endif
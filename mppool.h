@@ -0,0 +1,168 @@
+#ifndef SEM_2_MPPOOL_H
+#define SEM_2_MPPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+/*
+ * Pool vláken s kradením práce (work stealing) pro paralelní průchod rozsahem indexů.
+ * - Každé vlákno má vlastní frontu = souvislý úsek indexů, ze kterého si bere malé dávky.
+ * - Vlákno s prázdnou frontou ukradne jinému horní polovinu jeho zbývajícího úseku,
+ *   takže nerovnoměrně drahé položky (např. faktoriál vs. sčítání) se rozloží samy.
+ * - Vlákna žijí po celou dobu života poolu, volající vlákno pracuje jako vlákno 0.
+ */
+class WorkStealingPool {
+public:
+    // threads = 0 znamená počet vláken podle hardwaru
+    explicit WorkStealingPool(unsigned threads = 0)
+        : queues(threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads) {
+        for (unsigned id = 1; id < queues.size(); ++id) {
+            workers.emplace_back(&WorkStealingPool::workerLoop, this, id);
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // počet vláken včetně volajícího
+    unsigned size() const {
+        return static_cast<unsigned>(queues.size());
+    }
+
+    /*
+     * Zavolá fn(worker, i) pro všechna i z [0, count) a vrátí se až po dokončení.
+     * worker je číslo vlákna z [0, size()), fn nesmí vyhazovat výjimky.
+     * grain je počet indexů, které si vlákno bere ze své fronty najednou.
+     */
+    void parallelFor(size_t count, const std::function<void(unsigned, size_t)>& fn, size_t grain = 16) {
+        if (queues.size() == 1 || count <= grain) {
+            for (size_t i = 0; i < count; ++i) fn(0, i);
+            return;
+        }
+
+        // rovnoměrné počáteční rozdělení, zbytek dorovná kradení
+        const size_t n = queues.size();
+        for (size_t id = 0; id < n; ++id) {
+            std::lock_guard<std::mutex> lock(queues[id].mutex);
+            queues[id].begin = count * id / n;
+            queues[id].end = count * (id + 1) / n;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            job_grain = grain;
+            active = static_cast<unsigned>(n - 1);
+            ++generation;
+        }
+        wake.notify_all();
+
+        runWorker(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return active == 0; });
+        job = nullptr;
+    }
+
+private:
+    // fronta jednoho vlákna, zarovnaná na cache line kvůli false sharingu
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;   // nová práce nebo ukončení
+    std::condition_variable done;   // všechna vlákna doběhla
+    const std::function<void(unsigned, size_t)>* job = nullptr;
+    size_t job_grain = 1;
+    size_t generation = 0;
+    unsigned active = 0;
+    bool stopping = false;
+
+    void workerLoop(unsigned id) {
+        size_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+
+            lock.unlock();
+            runWorker(id);
+            lock.lock();
+
+            if (--active == 0) done.notify_one();
+        }
+    }
+
+    // zpracuje vlastní frontu a pak krade, dokud je co
+    void runWorker(unsigned id) {
+        const auto& fn = *job;
+        size_t begin = 0, end = 0;
+        while (true) {
+            if (!take(id, begin, end)) {
+                // steal jen naplní vlastní frontu, dávku z ní vezme až další take
+                if (!steal(id)) break;
+                continue;
+            }
+            for (size_t i = begin; i < end; ++i) fn(id, i);
+        }
+    }
+
+    // další dávka z vlastní fronty, false pokud je fronta prázdná
+    bool take(unsigned id, size_t& begin, size_t& end) {
+        Queue& q = queues[id];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.begin >= q.end) return false;
+        begin = q.begin;
+        end = std::min(q.end, q.begin + job_grain);
+        q.begin = end;
+        return true;
+    }
+
+    /*
+     * Ukradne horní polovinu zbývající práce prvnímu vláknu, které nějakou má,
+     * a přesune ji do vlastní fronty. Nikdy nedrží dva zámky najednou.
+     */
+    bool steal(unsigned id) {
+        const size_t n = queues.size();
+        for (size_t k = 1; k < n; ++k) {
+            Queue& victim = queues[(id + k) % n];
+            size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.begin >= victim.end) continue;
+                const size_t remaining = victim.end - victim.begin;
+                begin = remaining > job_grain ? victim.begin + remaining / 2 : victim.begin;
+                end = victim.end;
+                victim.end = begin;
+            }
+            Queue& own = queues[id];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = begin;
+            own.end = end;
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef SEM_2_MPPOW_H
+#define SEM_2_MPPOW_H
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <bit>
+#include "mpn.h"
+#include "mpvec.h"
+#include "mparena.h"
+#include "mpmul.h"
+#include "mpdiv.h"
+
+/*
+ * Umocňování nad poli limbů.
+ * - Exponent se prochází zleva doprava posuvným oknem: předpočítají se liché mocniny
+ *   base^1, base^3, ..., base^(2^w - 1) a každé okno exponentu stojí jedno násobení
+ *   místo až w násobení u binární metody.
+ * - Modulární umocňování s lichým modulem počítá v Montgomeryho reprezentaci
+ *   (redukce bez dělení, jen násobení limbem a posun), se sudým modulem Barrettovým
+ *   dělením s převrácenou hodnotou modulu spočítanou jednou (viz mpdiv.h).
+ */
+namespace mpn {
+
+namespace pow_detail {
+
+// počet bitů normalizovaného čísla
+inline std::size_t bitLength(const limb_t* a, std::size_t n) {
+    return n == 0 ? 0 : (n - 1) * LIMB_BITS + (LIMB_BITS - std::countl_zero(a[n - 1]));
+}
+
+inline bool testBit(const limb_t* a, std::size_t bit) {
+    return (a[bit / LIMB_BITS] >> (bit % LIMB_BITS)) & 1;
+}
+
+// velikost okna podle délky exponentu (větší okno = větší tabulka, ale méně násobení)
+inline unsigned windowSize(std::size_t bits) {
+    if (bits <= 8) return 1;
+    if (bits <= 24) return 3;
+    if (bits <= 80) return 4;
+    if (bits <= 240) return 5;
+    return 6;
+}
+
+/*
+ * Posuvné okno zleva doprava nad exponentem exp (en limbů, normalizovaný, nenulový).
+ * sqr(x) umocní x na druhou na místě, mul(x, y) spočítá x = x * y.
+ * Vrací base^exp, první okno se jen zkopíruje z tabulky (nenásobí se jedničkou).
+ */
+template<typename Value, typename Sqr, typename Mul>
+Value slidingWindow(const Value& base, const limb_t* exp, std::size_t en, Sqr sqr, Mul mul) {
+    const std::size_t bits = bitLength(exp, en);
+    const unsigned w = windowSize(bits);
+
+    // tabulka lichých mocnin: table[i] = base^(2i + 1), okno má nejvýše 6 bitů
+    std::array<Value, 32> table;
+    const std::size_t table_size = std::size_t{1} << (w - 1);
+    table[0] = base;
+    if (table_size > 1) {
+        Value base2 = base;
+        sqr(base2);
+        for (std::size_t i = 1; i < table_size; ++i) {
+            table[i] = table[i - 1];
+            mul(table[i], base2);
+        }
+    }
+
+    Value acc;
+    bool started = false;
+    std::size_t i = bits;
+    while (i > 0) {
+        if (!testBit(exp, i - 1)) {
+            if (started) sqr(acc);
+            --i;
+            continue;
+        }
+        // okno [low, i) končí jedničkou, takže jeho hodnota je lichá
+        std::size_t low = i > w ? i - w : 0;
+        while (!testBit(exp, low)) ++low;
+        std::size_t window = 0;
+        for (std::size_t k = i; k > low; --k) {
+            window = (window << 1) | testBit(exp, k - 1);
+            if (started) sqr(acc);
+        }
+        if (started) {
+            mul(acc, table[window >> 1]);
+        }
+        else {
+            acc = table[window >> 1];
+            started = true;
+        }
+        i = low;
+    }
+    return acc;
+}
+
+// r = x mod m (m má n limbů s nenulovým nejvyšším), r má n limbů
+inline void modReduce(limb_t* r, const limb_t* x, std::size_t xn, const limb_t* m, std::size_t n) {
+    xn = normalize(x, xn);
+    std::fill(r, r + n, limb_t{0});
+    if (cmp(x, xn, m, n) < 0) {
+        std::copy_n(x, xn, r);
+        return;
+    }
+    ScratchBuffer q(xn - n + 1);
+    if (n == 1)
+        r[0] = divrem_1(q.data(), x, xn, m[0]);
+    else
+        divrem(q.data(), r, x, xn, m, n);
+}
+
+// -m^(-1) mod B pro liché m0, Newtonova iterace zdvojí počet platných bitů v každém kroku
+inline limb_t montgomeryInverse(limb_t m0) {
+    limb_t inv = m0;   // m0 * m0 = 1 (mod 8), takže 3 bity platí hned
+    for (int i = 0; i < 5; ++i) inv *= 2 - m0 * inv;
+    return limb_t{0} - inv;
+}
+
+/*
+ * Montgomeryho redukce: r = t * B^(-n) mod m, t má 2n limbů (přepíše se) a t < m * B^n.
+ * Každý krok vynuluje nejnižší limb přičtením násobku m, výsledek je pak v horní polovině.
+ */
+inline void redc(limb_t* r, limb_t* t, const limb_t* m, std::size_t n, limb_t minv) {
+    limb_t top = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        limb_t carry = addmul_1(t + i, m, n, t[i] * minv);
+        // přenos do horních limbů, obvykle skončí hned v prvním
+        for (limb_t* p = t + i + n; carry != 0 && p != t + 2 * n; ++p) {
+            *p += carry;
+            carry = *p < carry;
+        }
+        top += carry;
+    }
+    // výsledek je menší než 2m, stačí nejvýše jedno odečtení
+    if (top != 0 || cmp(t + n, n, m, n) >= 0)
+        sub(r, t + n, n, m, n);
+    else
+        std::copy_n(t + n, n, r);
+}
+
+} // namespace pow_detail
+
+/*
+ * base^exp jako normalizované pole limbů, base má n limbů (normalizovaný, n >= 1), exp >= 1.
+ * limit > 0 ořízne všechny mezivýsledky (i výsledek) na limit limbů, tj. počítá modulo B^limit.
+ * Value je kontejner výsledku (std::vector nebo LimbVector).
+ */
+template<typename Value = std::vector<limb_t>>
+Value pow(const limb_t* base, std::size_t n, limb_t exp, std::size_t limit = 0) {
+    auto truncate = [limit](Value& x) {
+        if (limit != 0 && x.size() > limit) x.resize(limit);
+        x.resize(normalize(x.data(), x.size()));
+    };
+    // součin z odkládací arény do x (kapacita x se přepoužije), oříznutý na limit limbů
+    auto store = [limit](Value& x, const ScratchBuffer& r) {
+        const std::size_t len = normalize(r.data(), limit != 0 ? std::min(r.size(), limit) : r.size());
+        x.assign(r.begin(), r.begin() + len);
+    };
+    auto sqr = [&](Value& x) {
+        if (x.empty()) return;
+        ScratchBuffer r(2 * x.size());
+        mpn::sqr(r.data(), x.data(), x.size());
+        store(x, r);
+    };
+    auto mul = [&](Value& x, const Value& y) {
+        if (x.empty() || y.empty()) {
+            x.clear();
+            return;
+        }
+        ScratchBuffer r(x.size() + y.size());
+        if (x.size() >= y.size())
+            mpn::mul(r.data(), x.data(), x.size(), y.data(), y.size());
+        else
+            mpn::mul(r.data(), y.data(), y.size(), x.data(), x.size());
+        store(x, r);
+    };
+
+    Value b(base, base + n);
+    truncate(b);
+    return pow_detail::slidingWindow(b, &exp, 1, sqr, mul);
+}
+
+/*
+ * r = base^exp mod m.
+ * m má n limbů s nenulovým nejvyšším, base má bn <= n limbů a je menší než m,
+ * exp má en limbů (normalizovaný, nenulový). r má n limbů.
+ */
+inline void powm(limb_t* r, const limb_t* base, std::size_t bn, const limb_t* exp, std::size_t en,
+                 const limb_t* m, std::size_t n) {
+    // malé moduly (do 4 limbů) drží mocniny bez alokace, součiny a redukce jsou v aréně
+    using Value = LimbVector;
+    ScratchBuffer product(2 * n);
+
+    // součin dvou zredukovaných hodnot (n limbů) do product
+    auto multiply = [&](const Value& x, const Value& y) {
+        mpn::mul(product.data(), x.data(), n, y.data(), n);
+    };
+
+    if (m[0] & 1) {
+        // Montgomeryho reprezentace: x -> x * B^n mod m
+        const limb_t minv = pow_detail::montgomeryInverse(m[0]);
+        auto sqr = [&](Value& x) {
+            multiply(x, x);
+            pow_detail::redc(x.data(), product.data(), m, n, minv);
+        };
+        auto mul = [&](Value& x, const Value& y) {
+            multiply(x, y);
+            pow_detail::redc(x.data(), product.data(), m, n, minv);
+        };
+
+        ScratchBuffer shifted(bn + n, 0);
+        std::copy_n(base, bn, shifted.begin() + n);
+        Value b(n);
+        pow_detail::modReduce(b.data(), shifted.data(), shifted.size(), m, n);
+
+        Value acc = pow_detail::slidingWindow(b, exp, en, sqr, mul);
+        // zpět z Montgomeryho reprezentace: redukce acc * 1
+        std::fill(product.begin(), product.end(), limb_t{0});
+        std::copy(acc.begin(), acc.end(), product.begin());
+        pow_detail::redc(r, product.data(), m, n, minv);
+    }
+    else {
+        // sudý modul: Barrettova redukce s jednou spočítanou převrácenou hodnotou
+        ScratchBuffer inv(n + 2);
+        invert(inv.data(), m, n);
+        ScratchBuffer quotient(n + 1);
+        auto reduce = [&](Value& x) {
+            divrem_barrett(quotient.data(), x.data(), product.data(), 2 * n, m, n, inv.data());
+        };
+        auto sqr = [&](Value& x) {
+            multiply(x, x);
+            reduce(x);
+        };
+        auto mul = [&](Value& x, const Value& y) {
+            multiply(x, y);
+            reduce(x);
+        };
+
+        Value b(n, 0);
+        std::copy_n(base, bn, b.begin());
+        const Value acc = pow_detail::slidingWindow(b, exp, en, sqr, mul);
+        std::copy(acc.begin(), acc.end(), r);
+    }
+}
+
+} // namespace mpn
+
+#endif
@@ -0,0 +1,244 @@
+#ifndef SEM_2_MPSIMD_H
+#define SEM_2_MPSIMD_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define SEM_2_MPSIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Vektorová jádra pro sčítání, odčítání a porovnání dlouhých polí limbů.
+ * - Sčítání sečte všechny pruhy vektoru najednou a přenosy mezi nimi dopočítá
+ *   carry-lookahead: z bitových masek G (pruh přenos vyrobil, s < a) a P (pruh přenos
+ *   propustí, s = 2^64 - 1) dá přenosy do všech pruhů jediné sčítání (2G + P + cin) ^ P.
+ *   Pruhy s přenosem se pak zvýší o jedna, přenos do dalšího bloku je bit nad maskou.
+ * - Odčítání je totéž s výpůjčkami (G: a < b, P: a - b = 0).
+ * - Porovnání přeskočí shodné bloky od nejvyššího limbu vektorovým porovnáním na rovnost.
+ * - Úroveň (AVX-512, AVX2, skalární) se vybere za běhu podle procesoru, jádra jsou
+ *   přeložená s atributem target, takže zbytek programu nepotřebuje speciální přepínače.
+ *   Na jiných architekturách a překladačích zůstává jen skalární kód z mpn.h.
+ * - Jádra zpracují jen celé bloky a vrátí, kolik limbů zvládla, zbytek dopočítá mpn.h.
+ */
+namespace mpn::simd {
+
+using word = std::uint64_t;
+
+enum class Level { Scalar, AVX2, AVX512 };
+
+// od kolika limbů se vyplatí volat vektorové jádro (kratší pole zvládne skalární smyčka)
+constexpr std::size_t THRESHOLD = 8;
+
+// nejlepší úroveň, kterou procesor podporuje
+inline Level detect() noexcept {
+#ifdef SEM_2_MPSIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Level::AVX512;
+    if (__builtin_cpu_supports("avx2")) return Level::AVX2;
+#endif
+    return Level::Scalar;
+}
+
+namespace detail {
+
+inline std::atomic<Level>& activeLevel() noexcept {
+    static std::atomic<Level> active{detect()};
+    return active;
+}
+
+} // namespace detail
+
+// právě používaná úroveň
+inline Level level() noexcept {
+    return detail::activeLevel().load(std::memory_order_relaxed);
+}
+
+inline const char* levelName(Level value) noexcept {
+    switch (value) {
+        case Level::AVX512: return "AVX-512";
+        case Level::AVX2: return "AVX2";
+        case Level::Scalar: break;
+    }
+    return "skalarni";
+}
+
+// omezí používanou úroveň (srovnání v testech a benchmarku), víc než procesor umí nepovolí
+inline void setLevel(Level requested) noexcept {
+    detail::activeLevel().store(std::min(requested, detect()), std::memory_order_relaxed);
+}
+
+#ifdef SEM_2_MPSIMD_X86
+
+namespace detail {
+
+// r = a + b po 4 limbech, vrací počet zpracovaných limbů, carry je vstupní i výstupní přenos
+__attribute__((target("avx2")))
+inline std::size_t add_avx2(word* r, const word* a, const word* b, std::size_t n, word& carry) {
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    const __m256i lanes = _mm256_setr_epi64x(1, 2, 4, 8);
+    unsigned c = static_cast<unsigned>(carry);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        const __m256i s = _mm256_add_epi64(x, y);
+        // AVX2 neumí porovnání bez znaménka: převrácení nejvyššího bitu z něj udělá znaménkové
+        const __m256i gen = _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(s, sign));
+        const __m256i prop = _mm256_cmpeq_epi64(s, ones);
+        const unsigned g = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(gen)));
+        const unsigned p = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(prop)));
+        const unsigned into = (2 * g + p + c) ^ p;
+        // pruhy s příchozím přenosem: s - (-1)
+        const __m256i inc = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(into), lanes), lanes);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), _mm256_sub_epi64(s, inc));
+        c = into >> 4;
+    }
+    carry = c;
+    return i;
+}
+
+// r = a - b po 4 limbech, vrací počet zpracovaných limbů, borrow je vstupní i výstupní výpůjčka
+__attribute__((target("avx2")))
+inline std::size_t sub_avx2(word* r, const word* a, const word* b, std::size_t n, word& borrow) {
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lanes = _mm256_setr_epi64x(1, 2, 4, 8);
+    unsigned c = static_cast<unsigned>(borrow);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        const __m256i d = _mm256_sub_epi64(x, y);
+        const __m256i gen = _mm256_cmpgt_epi64(_mm256_xor_si256(y, sign), _mm256_xor_si256(x, sign));
+        const __m256i prop = _mm256_cmpeq_epi64(d, zero);
+        const unsigned g = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(gen)));
+        const unsigned p = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(prop)));
+        const unsigned into = (2 * g + p + c) ^ p;
+        // pruhy s příchozí výpůjčkou: d + (-1)
+        const __m256i dec = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(into), lanes), lanes);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), _mm256_add_epi64(d, dec));
+        c = into >> 4;
+    }
+    borrow = c;
+    return i;
+}
+
+// počet limbů zdola, za kterými se a a b shodují (viz skipEqualTop)
+__attribute__((target("avx2")))
+inline std::size_t skip_avx2(const word* a, const word* b, std::size_t n) {
+    while (n >= 4) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + n - 4));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + n - 4));
+        const unsigned eq = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, y))));
+        if (eq != 0xF) return n - 4 + static_cast<std::size_t>(32 - __builtin_clz(~eq & 0xF));
+        n -= 4;
+    }
+    return n;
+}
+
+__attribute__((target("avx512f")))
+inline std::size_t add_avx512(word* r, const word* a, const word* b, std::size_t n, word& carry) {
+    const __m512i ones = _mm512_set1_epi64(-1);
+    unsigned c = static_cast<unsigned>(carry);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512i x = _mm512_loadu_si512(a + i);
+        const __m512i y = _mm512_loadu_si512(b + i);
+        const __m512i s = _mm512_add_epi64(x, y);
+        const unsigned g = _mm512_cmplt_epu64_mask(s, x);
+        const unsigned p = _mm512_cmpeq_epi64_mask(s, ones);
+        const unsigned into = (2 * g + p + c) ^ p;
+        _mm512_storeu_si512(r + i, _mm512_mask_sub_epi64(s, static_cast<__mmask8>(into), s, ones));
+        c = into >> 8;
+    }
+    carry = c;
+    return i;
+}
+
+__attribute__((target("avx512f")))
+inline std::size_t sub_avx512(word* r, const word* a, const word* b, std::size_t n, word& borrow) {
+    const __m512i ones = _mm512_set1_epi64(-1);
+    unsigned c = static_cast<unsigned>(borrow);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512i x = _mm512_loadu_si512(a + i);
+        const __m512i y = _mm512_loadu_si512(b + i);
+        const __m512i d = _mm512_sub_epi64(x, y);
+        const unsigned g = _mm512_cmplt_epu64_mask(x, y);
+        const unsigned p = _mm512_cmpeq_epi64_mask(d, _mm512_setzero_si512());
+        const unsigned into = (2 * g + p + c) ^ p;
+        _mm512_storeu_si512(r + i, _mm512_mask_add_epi64(d, static_cast<__mmask8>(into), d, ones));
+        c = into >> 8;
+    }
+    borrow = c;
+    return i;
+}
+
+__attribute__((target("avx512f")))
+inline std::size_t skip_avx512(const word* a, const word* b, std::size_t n) {
+    while (n >= 8) {
+        const unsigned ne = _mm512_cmpneq_epi64_mask(_mm512_loadu_si512(a + n - 8), _mm512_loadu_si512(b + n - 8));
+        if (ne != 0) return n - 8 + static_cast<std::size_t>(32 - __builtin_clz(ne));
+        n -= 8;
+    }
+    return n;
+}
+
+} // namespace detail
+
+#endif
+
+/*
+ * r = a + b pro prvních n limbů po celých vektorových blocích (r smí být a nebo b).
+ * Vrací počet zpracovaných limbů (při skalární úrovni 0), carry se průběžně aktualizuje.
+ */
+inline std::size_t add(word* r, const word* a, const word* b, std::size_t n, word& carry) {
+#ifdef SEM_2_MPSIMD_X86
+    switch (level()) {
+        case Level::AVX512: return detail::add_avx512(r, a, b, n, carry);
+        case Level::AVX2: return detail::add_avx2(r, a, b, n, carry);
+        case Level::Scalar: break;
+    }
+#endif
+    (void)r, (void)a, (void)b, (void)n, (void)carry;
+    return 0;
+}
+
+// r = a - b, jinak stejně jako add
+inline std::size_t sub(word* r, const word* a, const word* b, std::size_t n, word& borrow) {
+#ifdef SEM_2_MPSIMD_X86
+    switch (level()) {
+        case Level::AVX512: return detail::sub_avx512(r, a, b, n, borrow);
+        case Level::AVX2: return detail::sub_avx2(r, a, b, n, borrow);
+        case Level::Scalar: break;
+    }
+#endif
+    (void)r, (void)a, (void)b, (void)n, (void)borrow;
+    return 0;
+}
+
+/*
+ * Přeskočí shodné limby a, b (délky n) od nejvyššího po celých vektorových blocích.
+ * Vrací m takové, že a[m, n) == b[m, n); zbytek [0, m) dořeší skalární smyčka
+ * (pokud vektor našel rozdíl, je to hned limb m - 1).
+ */
+inline std::size_t skipEqualTop(const word* a, const word* b, std::size_t n) {
+#ifdef SEM_2_MPSIMD_X86
+    switch (level()) {
+        case Level::AVX512: return detail::skip_avx512(a, b, n);
+        case Level::AVX2: return detail::skip_avx2(a, b, n);
+        case Level::Scalar: break;
+    }
+#endif
+    (void)a, (void)b;
+    return n;
+}
+
+} // namespace mpn::simd
+
+#endif
@@ -6,11 +6,14 @@
 #include <string>
 #include <array>
 #include <memory>
-#include <regex>
+#include <string_view>
 #include <exception>
-#include <cctype>
 #include <algorithm>
+#include <utility>
 #include "mpint.h"
+#include "mppool.h"
+#include "mpexpr.h"
+#include "mpbank.h"
 
 /*
  * Třída implementující terminálové rozhraní (REPL - Read-Eval-Print Loop).
@@ -23,227 +26,398 @@ public:
     ~MPTerm() = default;
 
     /*
-     * Hlavní smyčka aplikace.
+     * Přepne historii do trvalé banky v souboru (viz mpbank.h). Výsledky se od teď
+     * připisují do banky, $N sahá na kterýkoli z nich ($1 je nejnovější, i z dřívějších
+     * spuštění) a při čtení se limby kopírují přímo ze souboru do registru výrazu.
+     */
+    void openBank(const std::string& path) {
+        bank = std::make_unique<HistoryBank>(path);
+    }
+
+    /*
+     * Hlavní smyčka aplikace (interaktivní režim).
      * Zajišťuje načítání vstupu, tokenizaci a spuštění příkazů.
+     * Výstup každého řádku se vypíše hned, aby ho uživatel viděl před dalším promptem.
      */
     void run() {
         std::string line;
         while (true) {
-            std::cout << "mp>";
+            std::cout << "mp>" << std::flush;
             /* Načtení celého řádku od uživatele */
             if (!std::getline(std::cin, line)) break;
-            /* if is empty, continue */
-            if (line.empty()) continue;
-
-            /* Lexikální analýza: Převedení textu na tokeny */
-            std::vector<std::string> tokens;
-            try {
-                tokens = getTokensFromLine(line);
-            } catch (const std::exception& e) {
-                std::cout << "Chyba pri cteni vstupu: " << e.what() << std::endl;
-                continue;
-            }
 
-            /* debug print */
-            /*
-            for (const auto& t : tokens) {
-                std::cout << "[" << t << "] ";
-            }
-            if (!tokens.empty()) std::cout << std::endl;
-            */
+            const bool keep_going = processLine(line);
+            flushOutput();
+            if (!keep_going) break;
+        }
+        print("Koncim.\n");
+        flushOutput();
+    }
+
+    /*
+     * Dávkový režim (vstup z roury nebo souboru).
+     * Bez promptu, vstup se čte po velkých blocích a výstup se hromadí v bufferu,
+     * který se vypíše až když se zaplní, nebo na konci. Příkazy i historie $N
+     * se chovají stejně jako v interaktivním režimu.
+     */
+    void runBatch(std::istream& in = std::cin) {
+        forEachLine(in, [this](std::string_view line) {
+            const bool keep_going = processLine(line);
+            if (output.size() >= OUTPUT_BUFFER_SIZE) flushOutput();
+            return keep_going;
+        });
+        print("Koncim.\n");
+        flushOutput();
+    }
 
-            /* Validace prázdného vstupu po parsování */
-            if (tokens.empty()) {
-                std::cout << "Neplatne zadani (zadne zname tokeny)." << std::endl;
-                continue;
+    /*
+     * Paralelní dávkový režim.
+     * Vstup se zpracovává po blocích řádků. Řádky bez odkazu na historii ($N, bank, exit)
+     * se vyhodnotí na poolu vláken (každé vlákno má vlastní terminál s prázdnou historií),
+     * výsledky se pak v původním pořadí vypíšou a uloží do historie. Řádky s odkazem
+     * na historii se vyhodnotí až při tomto průchodu, tedy se stejnou historií
+     * jako v sériovém dávkovém režimu. threads = 0 znamená počet vláken podle hardwaru.
+     */
+    void runParallelBatch(std::istream& in = std::cin, unsigned threads = 0) {
+        WorkStealingPool pool(threads);
+        std::vector<MPTerm> workers(pool.size());
+        // vlákna poolu jsou už obsazená, faktoriál uvnitř řádku se nemá dál dělit
+        for (auto& w : workers) w.factorial_threads = 1;
+
+        std::string text;                                   // řádky aktuálního bloku za sebou
+        std::vector<std::pair<size_t, size_t>> spans;       // (začátek, délka) řádku v text
+        std::vector<std::string_view> lines;
+        std::vector<LineResult> results;
+
+        auto processChunk = [&]() {
+            lines.clear();
+            for (const auto& [offset, len] : spans) lines.emplace_back(text.data() + offset, len);
+            if (results.size() < lines.size()) results.resize(lines.size());
+
+            pool.parallelFor(lines.size(), [&](unsigned worker, size_t i) {
+                workers[worker].evaluateIndependent(lines[i], results[i]);
+            });
+
+            bool keep_going = true;
+            for (size_t i = 0; i < lines.size() && keep_going; ++i) {
+                LineResult& r = results[i];
+                if (r.deferred) {
+                    keep_going = processLine(lines[i]);
+                }
+                else {
+                    print(r.output);
+                    if (r.value && bank) {
+                        bank->append(*r.value);
+                    }
+                    else if (r.value) {
+                        moveHistory();
+                        history[0] = std::move(r.value);
+                    }
+                }
+                if (output.size() >= OUTPUT_BUFFER_SIZE) flushOutput();
             }
+            text.clear();
+            spans.clear();
+            return keep_going;
+        };
+
+        bool keep_going = forEachLine(in, [&](std::string_view line) {
+            spans.emplace_back(text.size(), line.size());
+            text.append(line);
+            return spans.size() < PARALLEL_CHUNK_LINES || processChunk();
+        });
+        if (keep_going && !spans.empty()) processChunk();
+
+        print("Koncim.\n");
+        flushOutput();
+    }
+
+    /*
+     * Tokenizer (Lexer).
+     * Jedním průchodem rozdělí řádek na tokeny (klíčová slova, odkazy na historii $N,
+     * čísla, operátory, závorky), ostatní znaky přeskočí. Tokeny jsou std::string_view do line,
+     * takže platí jen dokud se line nezmění; vektor tokens se jen vyprázdní a znovu plní,
+     * při opakovaném volání tedy nealokuje.
+     */
+    static void tokenize(std::string_view line, std::vector<std::string_view>& tokens) {
+        tokens.clear();
 
-            /* Ukončení programu příkazem "exit" */
-            if (tokens[0] == "exit") break;
+        size_t i = 0;
+        while (i < line.size()) {
+            const size_t start = i;
+            const char c = line[i];
 
-            /* Syntaktická analýza a výpočet */
-            if (!processTokens(tokens))
-                std::cout << "Neplatne zadani." << std::endl;
+            if (isDigit(c)) {
+                i = skipDigits(line, i);
+                tokens.push_back(line.substr(start, i - start));
+            }
+            else if (c == '$' && i + 1 < line.size() && isDigit(line[i + 1])) {
+                i = skipDigits(line, i + 1);
+                tokens.push_back(line.substr(start, i - start));
+            }
+            else if (line.substr(i, 4) == "exit" || line.substr(i, 4) == "bank") {
+                i += 4;
+                tokens.push_back(line.substr(start, 4));
+            }
+            else if (isOperator(c) || c == '(' || c == ')') {
+                // mínus je vždy samostatný token, unární od binárního rozliší parser (MPExpr),
+                // takže -2 ^ 2 je -(2 ^ 2) a -3 ! je -(3!)
+                ++i;
+                tokens.push_back(line.substr(start, 1));
+            }
+            else {
+                ++i;
+            }
         }
-        std::cout << "Koncim." << std::endl;
     }
 
-
 private:
     /*
      * Historie výsledků (Banka).
      * Používáme std::array s std::unique_ptr pro automatickou správu paměti.
      * Index 0 je $1 (nejnovější), Index 4 je $5 (nejstarší).
+     * Po openBank se historie nepoužívá a výsledky drží banka.
      */
     std::array<std::unique_ptr<MPInt<TERM_PRECISION>>, 5> history;
+    std::unique_ptr<HistoryBank> bank;
+
+    // velikost bloku čteného v dávkovém režimu a hranice, od které se vypíše výstupní buffer
+    static constexpr size_t INPUT_BLOCK_SIZE = 1 << 16;
+    static constexpr size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+    // počet řádků, které paralelní dávkový režim vyhodnotí najednou
+    static constexpr size_t PARALLEL_CHUNK_LINES = 1 << 15;
+
+    // výsledek řádku vyhodnoceného mimo pořadí (paralelní dávkový režim)
+    struct LineResult {
+        bool deferred = false;                          // řádek závisí na historii, vyhodnotí se v pořadí
+        std::string output;                             // text, který řádek vypsal
+        std::unique_ptr<MPInt<TERM_PRECISION>> value;   // výsledek pro historii (pokud nějaký je)
+    };
+
+    unsigned factorial_threads = 0;   // počet vláken pro faktoriál, 0 = podle hardwaru
+
+    std::string output;        // výstup čekající na vypsání
+    std::string number_text;   // pomocný buffer pro převod čísel na text
+    std::vector<std::string_view> tokens;   // tokeny aktuálního řádku (ukazují do řádku)
+    std::vector<MPInt<TERM_PRECISION>> registers;   // pracovní registry pro vyhodnocení výrazů
+    MPExpr<TERM_PRECISION> expr;   // přeložený výraz aktuálního řádku (přepoužívá paměť)
 
     /*
-     * Tokenizer (Lexer).
-     * Rozdělí vstupní řetězec na pole stringů (čísla, operátory, příkazy).
+     * Zpracování jednoho řádku vstupu.
+     * Vrací false, pokud uživatel zadal "exit".
      */
-    std::vector<std::string> getTokensFromLine(const std::string& line) const {
-        std::vector<std::string> raw_tokens;
+    bool processLine(std::string_view line) {
+        /* if is empty, continue */
+        if (line.empty()) return true;
 
-        // Hrubé rozdělení pomocí Regexu
-        // Hledáme: klíčová slova, odkazy na historii ($N), čísla nebo operátory.
-        std::regex re(R"((exit|bank|\$\d+|\d+|[-+*/%!]))");
-
-        auto begin = std::sregex_iterator(line.begin(), line.end(), re);
-        auto end = std::sregex_iterator();
+        /* Lexikální analýza: Převedení textu na tokeny */
+        tokenize(line, tokens);
+        return processTokenLine();
+    }
 
-        for (std::sregex_iterator i = begin; i != end; ++i) {
-            raw_tokens.push_back(i->str());
+    // zpracování tokenů aktuálního řádku (tokens), vrací false pro "exit"
+    bool processTokenLine() {
+        /* Validace prázdného vstupu po parsování */
+        if (tokens.empty()) {
+            print("Neplatne zadani (zadne zname tokeny).\n");
+            return true;
         }
 
-        // Kontextová analýza unárního mínusu.
-        // Řeší rozdíl mezi "5 - 3" (operátor) a "5 * -3" (záporné číslo).
-        std::vector<std::string> final_tokens;
-        bool expect_operand = true; // Na začátku nebo po operátoru čekáme číslo
-
-        for (size_t i = 0; i < raw_tokens.size(); ++i) {
-            const std::string& t = raw_tokens[i];
-
-            // Pokud vidíme "-" v kontextu, kde čekáme číslo, jde o unární mínus.
-            if (t == "-" && expect_operand && (i + 1 < raw_tokens.size())) {
-                const std::string& next = raw_tokens[i+1];
-                if (std::isdigit(next[0])) {
-                    final_tokens.push_back("-" + next); // Sloučení do jednoho tokenu
-                    i++; // Přeskočení čísla
-                    expect_operand = false;
-                    continue;
-                }
-            }
+        /* Ukončení programu příkazem "exit" */
+        if (tokens[0] == "exit") return false;
 
-            final_tokens.push_back(t);
+        /* Syntaktická analýza a výpočet */
+        if (!processTokens(tokens))
+            print("Neplatne zadani.\n");
+        return true;
+    }
 
-            // Aktualizace stavového automatu pro příští iteraci
-            if (t == "+" || t == "-" || t == "*" || t == "/" || t == "%") {
-                expect_operand = true;
-            } else if (t == "!") {
-                expect_operand = true;
-            } else {
-                expect_operand = false;
+    /*
+     * Rozdělí vstup na řádky a každý předá on_line(std::string_view).
+     * Vstup se čte po blocích INPUT_BLOCK_SIZE bez getline, řádek ležící celý v bloku
+     * se nekopíruje. Skončí na konci vstupu nebo když on_line vrátí false (to pak i vrací).
+     */
+    template<typename OnLine>
+    static bool forEachLine(std::istream& in, OnLine&& on_line) {
+        std::vector<char> block(INPUT_BLOCK_SIZE);
+        std::string pending;   // nedokončený řádek z konce předchozího bloku
+
+        while (true) {
+            const std::streamsize got = in.rdbuf()->sgetn(block.data(), static_cast<std::streamsize>(block.size()));
+            if (got <= 0) break;
+            std::string_view chunk(block.data(), static_cast<size_t>(got));
+
+            size_t newline;
+            while ((newline = chunk.find('\n')) != std::string_view::npos) {
+                bool keep_going;
+                if (pending.empty()) {
+                    keep_going = on_line(chunk.substr(0, newline));
+                }
+                else {
+                    pending.append(chunk.substr(0, newline));
+                    keep_going = on_line(std::string_view(pending));
+                    pending.clear();
+                }
+                if (!keep_going) return false;
+                chunk.remove_prefix(newline + 1);
             }
+            pending.append(chunk);
         }
+        // poslední řádek bez znaku konce řádku
+        if (!pending.empty()) return on_line(std::string_view(pending));
+        return true;
+    }
+
+    /*
+     * Vyhodnocení řádku mimo pořadí (volá vlákno paralelního dávkového režimu).
+     * Řádky, které čtou nebo vypisují historii nebo ukončují program, jen označí jako deferred.
+     */
+    void evaluateIndependent(std::string_view line, LineResult& result) {
+        result.output.clear();
+        result.value.reset();
+        result.deferred = false;
+        if (line.empty()) return;
+
+        tokenize(line, tokens);
+        result.deferred = std::ranges::any_of(tokens, [](std::string_view t) {
+            return t[0] == '$' || t == "bank" || t == "exit";
+        });
+        if (result.deferred) return;
+
+        history[0].reset();
+        processTokenLine();
+        // výstup a buffer si vymění místo, takže si oba nechají alokovanou kapacitu
+        std::swap(output, result.output);
+        output.clear();
+        result.value = std::move(history[0]);
+    }
+
+    // zápis do výstupního bufferu
+    void print(std::string_view text) {
+        output.append(text);
+    }
+
+    void print(const MPInt<TERM_PRECISION>& value) {
+        value.toString(number_text);
+        output.append(number_text);
+    }
+
+    void print(const MPIntView& value) {
+        output.append(value.toString());
+    }
 
-        return final_tokens;
+    // vypsání výstupního bufferu jedním zápisem
+    void flushOutput() {
+        std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+        std::cout.flush();
+        output.clear();
     }
 
     /*
      * Interpret příkazů.
-     * Rozhoduje o akci na základě počtu tokenů (Postfix/Infix logika).
+     * Příkaz "bank" vypíše historii, "a ^ b % m" je modulární mocnina a vše ostatní
+     * se přeloží jako výraz (viz mpexpr.h) a vyhodnotí nad registry terminálu.
      */
-    bool processTokens(const std::vector<std::string>& tokens) {
+    bool processTokens(const std::vector<std::string_view>& tokens) {
         if (tokens.empty()) return true;
 
         try {
-            // Jeden token (Příkaz "bank" nebo prosté uložení čísla)
-            if (tokens.size() == 1) {
-                if (tokens[0] == "bank") {
-                    for (size_t i = 0; i < history.size(); ++i) {
-                        std::cout << "$" << (i + 1) << " = ";
-                        if (history[i]) std::cout << *history[i] << std::endl;
-                        else std::cout << "(empty)" << std::endl;
-                    }
-                    return true;
+            // Příkaz "bank" - výpis historie
+            if (tokens.size() == 1 && tokens[0] == "bank" && bank) {
+                // z banky jen nejnovější výsledky, celá může mít miliony záznamů
+                for (size_t i = 0; i < std::min(history.size(), bank->size()); ++i) {
+                    print("$");
+                    print(std::to_string(i + 1));
+                    print(" = ");
+                    print(bank->recent(i));
+                    print("\n");
                 }
-                // Uživatel zadal jen číslo -> uložit do $1
-                MPInt<TERM_PRECISION> val = resolveValue(tokens[0]);
-                saveResult(val);
+                print("(v bance ");
+                print(std::to_string(bank->size()));
+                print(" vysledku)\n");
                 return true;
             }
-
-            // Dva tokeny (Unární operace, např. Faktoriál "5 !")
-            if (tokens.size() == 2) {
-                if (tokens[1] == "!") {
-                    MPInt<TERM_PRECISION> val = resolveValue(tokens[0]);
-                    saveResult(computeFactorial(val));
-                    return true;
+            if (tokens.size() == 1 && tokens[0] == "bank") {
+                for (size_t i = 0; i < history.size(); ++i) {
+                    print("$");
+                    print(std::to_string(i + 1));
+                    print(" = ");
+                    if (history[i]) print(*history[i]);
+                    else print("(empty)");
+                    print("\n");
                 }
-                return false;
-            }
-
-            // Tři tokeny (Binární operace, např. "1 + 2")
-            if (tokens.size() == 3) {
-                MPInt<TERM_PRECISION> left = resolveValue(tokens[0]);
-                std::string op = tokens[1];
-                MPInt<TERM_PRECISION> right = resolveValue(tokens[2]);
-
-                saveResult(computeOperator(left, op, right));
                 return true;
             }
 
-            // Pokud je tokenů víc nebo jiný počet, je to chyba
-            return false;
+            // Výraz s prioritami a závorkami, např. "($1 + 2) * 3 - 4 !" nebo "$1 ^ 3 % 5"
+            MPExpr<TERM_PRECISION>::compile(tokens, expr);
+            if (bank) {
+                saveResult(expr.evaluate(registers, [this](size_t index) {
+                    return bankValue(index);
+                }, factorial_threads));
+            }
+            else {
+                saveResult(expr.evaluate(registers, [this](size_t index) -> const MPInt<TERM_PRECISION>& {
+                    return historyValue(index);
+                }, factorial_threads));
+            }
+            return true;
 
         }
         // Exception Handling: Zachycení přetečení z MPInt
         catch (const typename MPInt<TERM_PRECISION>::OverflowException& e) {
-            std::cout << ">>> Chyba: Doslo k preteceni! \n Preteceny vysledek ulozen." << std::endl;
+            print(">>> Chyba: Doslo k preteceni! \n Preteceny vysledek ulozen.\n");
             // Uložíme i oříznutý výsledek, aby byla videt funkcnostu
             saveResult(e.getResult());
             return true;
         }
         catch (const std::exception& e) {
-            std::cout << "Error: " << e.what() << std::endl;
+            print("Error: ");
+            print(e.what());
+            print("\n");
             return false;
         }
     }
 
-    /*
-     * Pomocná metoda pro získání hodnoty.
-     * Rozlišuje mezi literálem ("100") a odkazem na historii ("$1").
-     */
-    MPInt<TERM_PRECISION> resolveValue(const std::string& token) {
-        if (token[0] == '$') {
-            try {
-                int index = std::stoi(token.substr(1)) - 1; // Převod $1 -> index 0
-
-                if (!checkIndex(index)) {
-                    throw std::invalid_argument("Neplatny index historie: " + token);
-                }
-                return *history[index];
-            }
-            catch (const std::invalid_argument&) { throw; }
-            catch (...) {
-                throw std::invalid_argument("Chybny format historie: " + token);
-            }
+    // hodnota $(index + 1) pro vyhodnocení výrazu
+    const MPInt<TERM_PRECISION>& historyValue(size_t index) {
+        if (!checkIndex(static_cast<int>(index))) {
+            throw std::invalid_argument("Neplatny index historie: $" + std::to_string(index + 1));
         }
-
-        return parseToken(token);
+        return *history[index];
     }
 
-    MPInt<TERM_PRECISION> parseToken(const std::string& token) {
-        MPInt<TERM_PRECISION> value;
-        try {
-            value = token; // Využití operator=(string) ve třídě MPInt
-        }
-        catch (const std::exception& e) {
-            throw std::runtime_error("Chyba při převodu čísla: " + std::string(e.what()));
+    // hodnota $(index + 1) z banky, limby zůstávají v souboru
+    MPIntView bankValue(size_t index) {
+        if (!checkIndex(static_cast<int>(index))) {
+            throw std::invalid_argument("Neplatny index historie: $" + std::to_string(index + 1));
         }
-        return value;
-    }
-
-    MPInt<TERM_PRECISION> computeOperator(const MPInt<TERM_PRECISION>& a, const std::string& op, const MPInt<TERM_PRECISION>& b) {
-        if (op == "+") return a + b;
-        if (op == "-") return a - b;
-        if (op == "*") return a * b;
-        if (op == "/") return a / b;
-        throw std::invalid_argument("Invalid operator: " + op);
-    }
-
-    MPInt<TERM_PRECISION> computeFactorial(const MPInt<TERM_PRECISION>& value) {
-        return value.factorial();
+        return bank->recent(index);
     }
 
     /*
      * Uložení výsledku do historie.
-     * Posune staré výsledky a nový vloží na začátek ($1).
+     * Posune staré výsledky a nový vloží na začátek ($1). Vypadlý nejstarší záznam
+     * se použije pro nový, takže plná historie už nealokuje.
      */
     void saveResult(MPInt<TERM_PRECISION> value) {
+        if (bank) {
+            bank->append(value);
+            print("$1 = ");
+            print(value);
+            print("\n");
+            return;
+        }
+        std::unique_ptr<MPInt<TERM_PRECISION>> slot = std::move(history.back());
         moveHistory();
-        history[0] = std::make_unique<MPInt<TERM_PRECISION>>(value);
-        std::cout << "$1 = " << *history[0] << std::endl;
+        if (slot)
+            *slot = std::move(value);
+        else
+            slot = std::make_unique<MPInt<TERM_PRECISION>>(std::move(value));
+        history[0] = std::move(slot);
+        print("$1 = ");
+        print(*history[0]);
+        print("\n");
     }
 
     /*
@@ -256,9 +430,24 @@ private:
         }
     }
 
+    static bool isDigit(const char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static bool isOperator(const char c) {
+        return c == '+' || c == '-' || c == '*' || c == '/' || c == '%' || c == '!' || c == '^';
+    }
+
+    static size_t skipDigits(std::string_view line, size_t i) {
+        while (i < line.size() && isDigit(line[i])) ++i;
+        return i;
+    }
+
     bool checkIndex(const int& index) {
-        if (index < 0 || index >= history.size() || !history[index]) {
-            std::cout << "Neplatný nebo prázdný index." << std::endl;
+        const bool stored = bank ? index >= 0 && static_cast<size_t>(index) < bank->size()
+                                 : index >= 0 && static_cast<size_t>(index) < history.size() && history[index];
+        if (!stored) {
+            print("Neplatný nebo prázdný index.\n");
             return false;
         }
         return true;
@@ -0,0 +1,238 @@
+#ifndef SEM_2_MPVEC_H
+#define SEM_2_MPVEC_H
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <memory_resource>
+#include "mpn.h"
+
+/*
+ * Vektor limbů s místem pro INLINE limbů přímo v objektu (small-buffer optimization).
+ * - Dokud délka nepřekročí INLINE, nealokuje se nic na haldě, takže malé Unlimited
+ *   hodnoty, jejich kopie i dočasné výsledky stojí stejně jako Limited čísla.
+ * - Větší délka se přesune na haldu a kapacita pak roste geometricky jako u std::vector.
+ *   Zpět do vnitřního bufferu se data nevrací, alokovaná kapacita se přepoužívá.
+ * - Rozhraní je podmnožina std::vector, kterou používá MPInt a funkce nad limby.
+ * - Změny kapacity jsou atomické: při std::bad_alloc zůstane obsah beze změny.
+ * - Paměť na haldě se bere z std::pmr::memory_resource nastaveného pro vlákno
+ *   (LimbResourceScope), blok si zdroj pamatuje a vrací se do něj.
+ */
+namespace mpn {
+
+namespace detail {
+
+inline std::pmr::memory_resource*& limbResourceSlot() noexcept {
+    thread_local std::pmr::memory_resource* resource = std::pmr::new_delete_resource();
+    return resource;
+}
+
+} // namespace detail
+
+// zdroj, ze kterého aktuální vlákno alokuje nové bloky vektorů limbů
+inline std::pmr::memory_resource* limbResource() noexcept {
+    return detail::limbResourceSlot();
+}
+
+/*
+ * Po dobu existence objektu alokuje aktuální vlákno bloky vektorů limbů (a tedy i čísla
+ * MPInt<0> přesahující vnitřní buffer) ze zadaného zdroje, např. z
+ * std::pmr::monotonic_buffer_resource pro dávku výpočtů s mnoha dočasnými hodnotami.
+ * Hodnoty alokované ze zdroje se do něj vrátí i po skončení rozsahu,
+ * zdroj proto musí přežít všechna čísla, která z něj alokovala.
+ */
+class LimbResourceScope {
+public:
+    explicit LimbResourceScope(std::pmr::memory_resource* resource) noexcept
+        : previous(std::exchange(detail::limbResourceSlot(), resource)) {}
+
+    LimbResourceScope(const LimbResourceScope&) = delete;
+    LimbResourceScope& operator=(const LimbResourceScope&) = delete;
+
+    ~LimbResourceScope() {
+        detail::limbResourceSlot() = previous;
+    }
+
+private:
+    std::pmr::memory_resource* previous;
+};
+
+template<std::size_t INLINE>
+class SmallLimbVector {
+    static_assert(INLINE > 0, "SmallLimbVector needs at least one inline limb");
+
+public:
+    using value_type = limb_t;
+    using size_type = std::size_t;
+    using iterator = limb_t*;
+    using const_iterator = const limb_t*;
+
+    SmallLimbVector() noexcept = default;
+
+    // n limbů s hodnotou value
+    explicit SmallLimbVector(std::size_t n, limb_t value = 0) {
+        assign(n, value);
+    }
+
+    SmallLimbVector(const limb_t* first, const limb_t* last) {
+        assign(first, last);
+    }
+
+    SmallLimbVector(const SmallLimbVector& other) {
+        assign(other.begin(), other.end());
+    }
+
+    SmallLimbVector(SmallLimbVector&& other) noexcept {
+        steal(other);
+    }
+
+    SmallLimbVector& operator=(const SmallLimbVector& other) {
+        if (this != &other) assign(other.begin(), other.end());
+        return *this;
+    }
+
+    SmallLimbVector& operator=(SmallLimbVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~SmallLimbVector() {
+        release();
+    }
+
+    std::size_t size() const noexcept { return len; }
+    std::size_t capacity() const noexcept { return cap; }
+    bool empty() const noexcept { return len == 0; }
+    // true, pokud data leží ve vnitřním bufferu (bez alokace)
+    bool isInline() const noexcept { return ptr == local; }
+
+    limb_t* data() noexcept { return ptr; }
+    const limb_t* data() const noexcept { return ptr; }
+    limb_t* begin() noexcept { return ptr; }
+    const limb_t* begin() const noexcept { return ptr; }
+    limb_t* end() noexcept { return ptr + len; }
+    const limb_t* end() const noexcept { return ptr + len; }
+
+    limb_t& operator[](std::size_t i) noexcept { return ptr[i]; }
+    const limb_t& operator[](std::size_t i) const noexcept { return ptr[i]; }
+    limb_t& back() noexcept { return ptr[len - 1]; }
+    const limb_t& back() const noexcept { return ptr[len - 1]; }
+
+    void reserve(std::size_t n) {
+        if (n > cap) reallocate(n);
+    }
+
+    void resize(std::size_t n, limb_t value = 0) {
+        if (n > cap) reallocate(std::max(n, 2 * cap));
+        if (n > len) std::fill(ptr + len, ptr + n, value);
+        len = n;
+    }
+
+    void assign(std::size_t n, limb_t value) {
+        if (n > cap) reallocate(n);
+        std::fill(ptr, ptr + n, value);
+        len = n;
+    }
+
+    // zdroj smí ležet ve vlastním bufferu (kopíruje se dřív, než se starý buffer uvolní)
+    void assign(const limb_t* first, const limb_t* last) {
+        const std::size_t n = static_cast<std::size_t>(last - first);
+        if (n > cap) {
+            assignFresh(first, n);
+            return;
+        }
+        std::copy(first, last, ptr);
+        len = n;
+    }
+
+    void push_back(limb_t value) {
+        if (len == cap) reallocate(2 * cap);
+        ptr[len++] = value;
+    }
+
+    void pop_back() noexcept {
+        --len;
+    }
+
+    void clear() noexcept {
+        len = 0;
+    }
+
+private:
+    limb_t* ptr = local;
+    std::size_t len = 0;
+    std::size_t cap = INLINE;
+    limb_t local[INLINE];
+
+    // přesun na haldu s kapacitou new_cap (> cap), obsah se zachová
+    void reallocate(std::size_t new_cap) {
+        limb_t* fresh = allocateBlock(new_cap);
+        const std::size_t keep = std::min(len, new_cap);
+        std::copy_n(ptr, keep, fresh);
+        release();
+        ptr = fresh;
+        cap = new_cap;
+        len = keep;
+    }
+
+    // assign do nového bufferu na haldě (n > cap)
+    void assignFresh(const limb_t* first, std::size_t n) {
+        limb_t* fresh = allocateBlock(n);
+        std::copy_n(first, n, fresh);
+        release();
+        ptr = fresh;
+        cap = n;
+        len = n;
+    }
+
+    // uvolní haldu a vrátí se do prázdného vnitřního bufferu
+    void release() noexcept {
+        if (ptr != local) deallocateBlock(ptr, cap);
+        ptr = local;
+        cap = INLINE;
+        len = 0;
+    }
+
+    // blok n limbů z aktuálního zdroje, v limbu před daty je ukazatel na zdroj
+    static limb_t* allocateBlock(std::size_t n) {
+        static_assert(sizeof(std::pmr::memory_resource*) <= sizeof(limb_t));
+        std::pmr::memory_resource* resource = limbResource();
+        auto* block = static_cast<limb_t*>(resource->allocate((n + 1) * sizeof(limb_t), alignof(limb_t)));
+        std::memcpy(block, &resource, sizeof(resource));
+        return block + 1;
+    }
+
+    static void deallocateBlock(limb_t* p, std::size_t n) noexcept {
+        limb_t* block = p - 1;
+        std::pmr::memory_resource* resource;
+        std::memcpy(&resource, block, sizeof(resource));
+        resource->deallocate(block, (n + 1) * sizeof(limb_t), alignof(limb_t));
+    }
+
+    // převezme obsah other (*this je prázdný a ve vnitřním bufferu), other zůstane prázdný
+    void steal(SmallLimbVector& other) noexcept {
+        if (other.ptr == other.local) {
+            std::copy(other.local, other.local + other.len, local);
+            len = other.len;
+        }
+        else {
+            ptr = other.ptr;
+            cap = other.cap;
+            len = other.len;
+            other.ptr = other.local;
+            other.cap = INLINE;
+        }
+        other.len = 0;
+    }
+};
+
+// úložiště Unlimited MPInt: hodnoty do 256 bitů bez alokace
+using LimbVector = SmallLimbVector<4>;
+
+} // namespace mpn
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef SEM_2_MPWIRE_H
+#define SEM_2_MPWIRE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <bit>
+#include <stdexcept>
+#include "mpn.h"
+
+/*
+ * Binární formát čísla pro ukládání a přenos.
+ * - Hlavička je 8 bajtů Little Endian: bit 0 je znaménko, bity 1..63 počet limbů.
+ * - Za ní následují limby po 8 bajtech Little Endian, nejnižší první, nejvyšší je nenulový.
+ *   Nula má jen hlavičku (0 limbů, kladné znaménko).
+ * - Délka zápisu je vždy násobek 8 bajtů, takže čísla zapsaná za sebou do zarovnaného
+ *   bufferu mají zarovnané i limby a na Little Endian procesoru je lze číst přímo
+ *   z bufferu bez kopírování (viz MPIntView v mpint.h).
+ * - Čtení ověřuje délku i tvar, poškozená data vyhodí std::invalid_argument.
+ */
+namespace mpn::wire {
+
+constexpr std::size_t HEADER_BYTES = 8;
+
+// hlavička zápisu: počet limbů a znaménko
+struct Header {
+    std::size_t len;
+    bool negative;
+};
+
+// počet bajtů zápisu čísla s n limby
+constexpr std::size_t encodedSize(std::size_t n) {
+    return HEADER_BYTES + n * LIMB_BYTES;
+}
+
+namespace detail {
+
+inline void storeWord(std::byte* out, limb_t value) {
+    if constexpr (std::endian::native != std::endian::little) {
+        for (std::size_t i = 0; i < LIMB_BYTES; ++i) out[i] = static_cast<std::byte>(value >> (8 * i));
+    }
+    else {
+        std::memcpy(out, &value, LIMB_BYTES);
+    }
+}
+
+inline limb_t loadWord(const std::byte* in) {
+    limb_t value = 0;
+    if constexpr (std::endian::native != std::endian::little) {
+        for (std::size_t i = 0; i < LIMB_BYTES; ++i) value |= static_cast<limb_t>(in[i]) << (8 * i);
+    }
+    else {
+        std::memcpy(&value, in, LIMB_BYTES);
+    }
+    return value;
+}
+
+} // namespace detail
+
+/*
+ * Zapíše x (n normalizovaných limbů) na out, které má aspoň encodedSize(n) bajtů.
+ * Vrací počet zapsaných bajtů. Na Little Endian je to jedna kopie celého pole.
+ */
+inline std::size_t encode(std::byte* out, const limb_t* x, std::size_t n, bool negative) {
+    detail::storeWord(out, static_cast<limb_t>(n) << 1 | (negative && n > 0 ? 1 : 0));
+    if constexpr (std::endian::native != std::endian::little) {
+        for (std::size_t i = 0; i < n; ++i) detail::storeWord(out + encodedSize(i), x[i]);
+    }
+    else if (n > 0) {
+        std::memcpy(out + HEADER_BYTES, x, n * LIMB_BYTES);
+    }
+    return encodedSize(n);
+}
+
+// přečte a ověří hlavičku čísla na začátku in (včetně toho, že se do in vejdou limby)
+inline Header decodeHeader(std::span<const std::byte> in) {
+    if (in.size() < HEADER_BYTES) {
+        throw std::invalid_argument("MPInt serialized data is truncated");
+    }
+    const limb_t word = detail::loadWord(in.data());
+    const Header header{static_cast<std::size_t>(word >> 1), (word & 1) != 0};
+    if (header.len > (in.size() - HEADER_BYTES) / LIMB_BYTES) {
+        throw std::invalid_argument("MPInt serialized data is truncated");
+    }
+    // jediný zápis každé hodnoty: nejvyšší limb nenulový, nula bez znaménka
+    const bool top_zero = header.len > 0 && detail::loadWord(in.data() + encodedSize(header.len - 1)) == 0;
+    if (top_zero || (header.negative && header.len == 0)) {
+        throw std::invalid_argument("MPInt serialized data is not normalized");
+    }
+    return header;
+}
+
+// zkopíruje n limbů zápisu z in (ověřeného decodeHeader) do out
+inline void decodeLimbs(limb_t* out, std::span<const std::byte> in, std::size_t n) {
+    if constexpr (std::endian::native != std::endian::little) {
+        for (std::size_t i = 0; i < n; ++i) out[i] = detail::loadWord(in.data() + encodedSize(i));
+    }
+    else if (n > 0) {
+        std::memcpy(out, in.data() + HEADER_BYTES, n * LIMB_BYTES);
+    }
+}
+
+/*
+ * Ukazatel na limby zápisu přímo v bufferu in (ověřeném decodeHeader), bez kopie.
+ * Jde jen na Little Endian procesoru a limby musí být zarovnané na 8 bajtů.
+ */
+inline const limb_t* viewLimbs(std::span<const std::byte> in) {
+    const std::byte* limbs = in.data() + HEADER_BYTES;
+    if (std::endian::native != std::endian::little || reinterpret_cast<std::uintptr_t>(limbs) % alignof(limb_t) != 0) {
+        throw std::invalid_argument("MPInt serialized data cannot be viewed in place (unaligned buffer)");
+    }
+    return reinterpret_cast<const limb_t*>(limbs);
+}
+
+} // namespace mpn::wire
+
+#endif